@@ -1,20 +1,24 @@
 use libc::size_t;
+use std::convert::TryInto;
 use std::io::Cursor;
 use std::ptr::null;
 use std::slice;
-use std::sync::Arc;
+use std::sync::{Arc, RwLock};
 
 use rustls::sign::CertifiedKey;
 use rustls::{
-    AllowAnyAnonymousOrAuthenticatedClient, AllowAnyAuthenticatedClient, RootCertStore,
-    SupportedCipherSuite, ALL_CIPHERSUITES,
+    AllowAnyAnonymousOrAuthenticatedClient, AllowAnyAuthenticatedClient, OwnedTrustAnchor,
+    RootCertStore, SupportedCipherSuite, ALL_CIPHERSUITES,
 };
 use rustls::{Certificate, PrivateKey};
 use rustls_pemfile::{certs, pkcs8_private_keys, rsa_private_keys};
 
 use crate::error::rustls_result;
 use crate::rslice::rustls_slice_bytes;
-use crate::{ffi_panic_boundary, try_mut_from_ptr, try_ref_from_ptr, try_slice, CastPtr};
+use crate::{
+    arc_with_incref_from_raw, ffi_panic_boundary, try_mut_from_ptr, try_mut_slice,
+    try_ref_from_ptr, try_slice, CastPtr,
+};
 use rustls_result::NullParameter;
 use std::ops::Deref;
 
@@ -147,6 +151,57 @@ pub extern "C" fn rustls_certified_key_build(
     }
 }
 
+/// Build a `rustls_certified_key` from DER-encoded inputs, with no PEM
+/// decoding involved. `cert_chain` must point to `cert_chain_len`
+/// `rustls_slice_bytes`, each containing one DER-encoded certificate, with
+/// the end-entity certificate first. `private_key` must point to
+/// `private_key_len` bytes of DER (PKCS8 or RSA). This is useful when
+/// certificates are kept in a binary store (possibly memory-mapped):
+/// loading a large certificate inventory this way avoids the base64
+/// decoding cost of rustls_certified_key_build. All inputs are copied;
+/// the caller's buffers only need to live for the duration of the call.
+///
+/// Like rustls_certified_key_build, this does not check the validity of
+/// the certificate chain; the consistency of the end-entity certificate
+/// is checked when the key is used in a config.
+///
+/// For memory lifetime, see rustls_certified_key_build.
+#[no_mangle]
+pub extern "C" fn rustls_certified_key_build_der(
+    cert_chain: *const rustls_slice_bytes,
+    cert_chain_len: size_t,
+    private_key: *const u8,
+    private_key_len: size_t,
+    certified_key_out: *mut *const rustls_certified_key,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let certified_key_out: &mut *const rustls_certified_key = unsafe {
+            match certified_key_out.as_mut() {
+                Some(c) => c,
+                None => return NullParameter,
+            }
+        };
+        let cert_chain: &[rustls_slice_bytes] = try_slice!(cert_chain, cert_chain_len);
+        if cert_chain.is_empty() {
+            return rustls_result::CertificateParseError;
+        }
+        let private_key: &[u8] = try_slice!(private_key, private_key_len);
+        let mut parsed_chain: Vec<Certificate> = Vec::with_capacity(cert_chain.len());
+        for cert in cert_chain {
+            let cert: &[u8] = try_slice!(cert.data, cert.len);
+            parsed_chain.push(Certificate(cert.to_vec()));
+        }
+        let signing_key =
+            match rustls::sign::any_supported_type(&PrivateKey(private_key.to_vec())) {
+                Ok(key) => key,
+                Err(_) => return rustls_result::PrivateKeyParseError,
+            };
+        let certified_key = CertifiedKey::new(parsed_chain, Arc::new(signing_key));
+        *certified_key_out = Arc::into_raw(Arc::new(certified_key)) as *const _;
+        return rustls_result::Ok
+    }
+}
+
 /// Return the i-th rustls_certificate in the rustls_certified_key. 0 gives the
 /// end-entity certificate. 1 and higher give certificates from the chain.
 /// Indexes higher the the last available certificate return NULL.
@@ -267,6 +322,102 @@ fn certified_key_build(
     ))
 }
 
+/// A certified key whose OCSP response can be replaced while server
+/// configs are using the key. Handshakes pick up the current response at
+/// the time the certificate is resolved, so refreshing a staple is a
+/// pointer swap instead of a config rebuild. The object is safe for
+/// concurrent use; a swap does not affect handshakes already in flight.
+/// Under the hood, this object corresponds to an
+/// Arc<SwappableCertifiedKey>.
+pub struct rustls_swappable_certified_key {
+    // We use the opaque struct pattern to tell C about our types without
+    // telling them what's inside.
+    // https://doc.rust-lang.org/nomicon/ffi.html#representing-opaque-structs
+    _private: [u8; 0],
+}
+
+pub(crate) struct SwappableCertifiedKey {
+    inner: RwLock<Arc<CertifiedKey>>,
+}
+
+impl SwappableCertifiedKey {
+    /// Return the key as of this moment. Later swaps do not affect the
+    /// returned Arc.
+    pub(crate) fn current(&self) -> Arc<CertifiedKey> {
+        self.inner.read().unwrap().clone()
+    }
+}
+
+impl CastPtr for rustls_swappable_certified_key {
+    type RustType = SwappableCertifiedKey;
+}
+
+/// Build a rustls_swappable_certified_key wrapping the given certified
+/// key. The swappable key holds a reference to `key`; the caller may free
+/// its own copy at any time. The returned pointer is reference-counted
+/// like a rustls_certified_key and must be freed with
+/// rustls_swappable_certified_key_free. If `key` is NULL, returns NULL.
+#[no_mangle]
+pub extern "C" fn rustls_swappable_certified_key_new(
+    key: *const rustls_certified_key,
+) -> *const rustls_swappable_certified_key {
+    ffi_panic_boundary! {
+        let key: Arc<CertifiedKey> = unsafe {
+            match (key as *const CertifiedKey).as_ref() {
+                Some(c) => arc_with_incref_from_raw(c),
+                None => return null(),
+            }
+        };
+        let skey = SwappableCertifiedKey {
+            inner: RwLock::new(key),
+        };
+        Arc::into_raw(Arc::new(skey)) as *const _
+    }
+}
+
+/// Replace the OCSP response of the swappable key with the given DER
+/// encoded bytes, atomically publishing it to every config and resolver
+/// referencing the key. Pass NULL to clear any present OCSP data. The
+/// bytes are copied. This is the in-place counterpart of
+/// rustls_certified_key_clone_with_ocsp: an hourly staple refresh over a
+/// large certificate inventory is one cheap call per key, with no config
+/// rebuild and no connection draining.
+#[no_mangle]
+pub extern "C" fn rustls_swappable_certified_key_set_ocsp(
+    key: *const rustls_swappable_certified_key,
+    ocsp_response: *const rustls_slice_bytes,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let key: &SwappableCertifiedKey = try_ref_from_ptr!(key);
+        let mut new_key = key.current().deref().clone();
+        if !ocsp_response.is_null() {
+            let ocsp_slice = unsafe{ &*ocsp_response };
+            new_key.ocsp = Some(Vec::from(try_slice!(ocsp_slice.data, ocsp_slice.len)));
+        } else {
+            new_key.ocsp = None;
+        }
+        *key.inner.write().unwrap() = Arc::new(new_key);
+        rustls_result::Ok
+    }
+}
+
+/// "Free" a rustls_swappable_certified_key previously returned from
+/// rustls_swappable_certified_key_new. Since it is actually an atomically
+/// reference-counted pointer, extant configs and resolvers may still hold
+/// an internal reference to the Rust object. However, C code must consider
+/// this pointer unusable after "free"ing it.
+/// Calling with NULL is fine. Must not be called twice with the same value.
+#[no_mangle]
+pub extern "C" fn rustls_swappable_certified_key_free(key: *const rustls_swappable_certified_key) {
+    ffi_panic_boundary! {
+        if key.is_null() {
+            return;
+        }
+        // To free the swappable key, we reconstruct the Arc.
+        unsafe { drop(Arc::from_raw(key)) };
+    }
+}
+
 /// A root cert store that is done being constructed and is now read-only.
 /// Under the hood, this object corresponds to an Arc<RootCertStore>.
 /// https://docs.rs/rustls/0.19.0/rustls/struct.RootCertStore.html
@@ -331,6 +482,160 @@ pub extern "C" fn rustls_root_cert_store_add_pem(
     }
 }
 
+// Magic and version prefix of the binary root cert store format produced
+// by rustls_root_cert_store_serialize.
+const ROOT_STORE_FORMAT: &[u8; 5] = b"crts\x01";
+
+fn push_field(out: &mut Vec<u8>, field: &[u8]) {
+    out.extend_from_slice(&(field.len() as u32).to_le_bytes());
+    out.extend_from_slice(field);
+}
+
+fn serialize_root_store(store: &RootCertStore) -> Vec<u8> {
+    let mut out = Vec::new();
+    out.extend_from_slice(ROOT_STORE_FORMAT);
+    out.extend_from_slice(&(store.roots.len() as u32).to_le_bytes());
+    for root in &store.roots {
+        let anchor = root.to_trust_anchor();
+        push_field(&mut out, anchor.subject);
+        push_field(&mut out, anchor.spki);
+        match anchor.name_constraints {
+            Some(nc) => {
+                out.push(1);
+                push_field(&mut out, nc);
+            }
+            None => out.push(0),
+        }
+    }
+    out
+}
+
+fn take<'a>(data: &mut &'a [u8], n: usize) -> Option<&'a [u8]> {
+    if data.len() < n {
+        return None;
+    }
+    let (head, rest) = data.split_at(n);
+    *data = rest;
+    Some(head)
+}
+
+fn take_u32(data: &mut &[u8]) -> Option<u32> {
+    let bytes = take(data, 4)?;
+    Some(u32::from_le_bytes(bytes.try_into().ok()?))
+}
+
+fn take_field<'a>(data: &mut &'a [u8]) -> Option<&'a [u8]> {
+    let len = take_u32(data)? as usize;
+    take(data, len)
+}
+
+fn deserialize_root_store(mut data: &[u8]) -> Option<Vec<OwnedTrustAnchor>> {
+    if take(&mut data, ROOT_STORE_FORMAT.len())? != ROOT_STORE_FORMAT {
+        return None;
+    }
+    let count = take_u32(&mut data)? as usize;
+    let mut roots: Vec<OwnedTrustAnchor> = Vec::new();
+    for _ in 0..count {
+        let subject = take_field(&mut data)?;
+        let spki = take_field(&mut data)?;
+        let name_constraints = match take(&mut data, 1)? {
+            [0] => None,
+            [1] => Some(take_field(&mut data)?),
+            _ => return None,
+        };
+        roots.push(OwnedTrustAnchor::from_trust_anchor(&webpki::TrustAnchor {
+            subject,
+            spki,
+            name_constraints,
+        }));
+    }
+    if !data.is_empty() {
+        return None;
+    }
+    Some(roots)
+}
+
+/// Serialize the root cert store into a compact binary format, copying it
+/// to `buf` which can hold up to `count` bytes, and storing the serialized
+/// length in `out_n`. If the serialized form is larger than `count`, stores
+/// the required size in `out_n` and returns
+/// RUSTLS_RESULT_INSUFFICIENT_SIZE without writing to `buf`.
+///
+/// The blob can be written to a file once and then loaded by many worker
+/// processes with rustls_root_cert_store_add_serialized, which only has to
+/// do length-delimited copies: no PEM decoding or certificate parsing is
+/// repeated per process. The format is versioned but private to this
+/// library; do not parse it yourself.
+#[no_mangle]
+pub extern "C" fn rustls_root_cert_store_serialize(
+    store: *const rustls_root_cert_store,
+    buf: *mut u8,
+    count: size_t,
+    out_n: *mut size_t,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let store: &RootCertStore = try_ref_from_ptr!(store);
+        let write_buf: &mut [u8] = try_mut_slice!(buf, count);
+        let out_n: &mut size_t = try_mut_from_ptr!(out_n);
+        let data = serialize_root_store(store);
+        *out_n = data.len();
+        if data.len() > write_buf.len() {
+            return rustls_result::InsufficientSize;
+        }
+        write_buf[..data.len()].copy_from_slice(&data);
+        rustls_result::Ok
+    }
+}
+
+/// Add all trust anchors from a blob previously produced by
+/// rustls_root_cert_store_serialize. `data` may point into a memory-mapped
+/// file; the bytes are copied and need not stay valid after the call. A
+/// blob that was not produced by rustls_root_cert_store_serialize, or that
+/// is truncated or otherwise damaged, returns a CertificateParseError and
+/// leaves the store unchanged.
+#[no_mangle]
+pub extern "C" fn rustls_root_cert_store_add_serialized(
+    store: *mut rustls_root_cert_store,
+    data: *const u8,
+    len: size_t,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let store: &mut RootCertStore = try_mut_from_ptr!(store);
+        let data: &[u8] = try_slice!(data, len);
+        let mut roots = match deserialize_root_store(data) {
+            Some(r) => r,
+            None => return rustls_result::CertificateParseError,
+        };
+        store.roots.append(&mut roots);
+        rustls_result::Ok
+    }
+}
+
+#[test]
+fn test_root_store_serialize_roundtrip() {
+    let anchor = webpki::TrustAnchor {
+        subject: b"subject",
+        spki: b"spki",
+        name_constraints: Some(b"nc"),
+    };
+    let mut store = RootCertStore::empty();
+    store
+        .roots
+        .push(OwnedTrustAnchor::from_trust_anchor(&anchor));
+
+    let data = serialize_root_store(&store);
+    let roots = deserialize_root_store(&data).unwrap();
+    assert_eq!(roots.len(), 1);
+    let got = roots[0].to_trust_anchor();
+    assert_eq!(got.subject, b"subject");
+    assert_eq!(got.spki, b"spki");
+    assert_eq!(got.name_constraints, Some(&b"nc"[..]));
+
+    // Damaged input must be rejected, not half-applied.
+    assert!(deserialize_root_store(&data[..data.len() - 1]).is_none());
+    assert!(deserialize_root_store(b"not a store").is_none());
+}
+
 /// "Free" a rustls_root_cert_store previously returned from
 /// rustls_root_cert_store_builder_build. Since rustls_root_cert_store is actually an
 /// atomically reference-counted pointer, extant rustls_root_cert_store may still
@@ -252,6 +252,60 @@ pub extern "C" fn rustls_client_config_builder_dangerous_set_certificate_verifie
     }
 }
 
+/// A verifier that accepts any chain at the TLS layer, on the promise that
+/// the application performs the actual verification after the handshake.
+/// See rustls_client_config_builder_dangerous_set_deferred_certificate_verification.
+struct DeferredVerifier {}
+
+impl rustls::ServerCertVerifier for DeferredVerifier {
+    fn verify_server_cert(
+        &self,
+        _roots: &RootCertStore,
+        presented_certs: &[Certificate],
+        _dns_name: DNSNameRef<'_>,
+        _ocsp_response: &[u8],
+    ) -> Result<ServerCertVerified, TLSError> {
+        if presented_certs.is_empty() {
+            return Err(TLSError::NoCertificatesPresented);
+        }
+        Ok(ServerCertVerified::assertion())
+    }
+}
+
+/// Defer certificate verification to the application, after the handshake.
+///
+/// With this set, the handshake completes without the certificate chain
+/// being verified, so slow checks (revocation lookups against a local
+/// database, CT verification, and so on) no longer run on - and stall -
+/// the thread driving rustls_connection_process_new_packets. Instead, once
+/// rustls_connection_is_handshaking returns false, the application must
+/// retrieve the chain with rustls_connection_get_peer_certificate and
+/// verify it on whatever thread it likes, and must close the connection if
+/// verification fails.
+///
+/// This is dangerous in the same way as
+/// rustls_client_config_builder_dangerous_set_certificate_verifier with an
+/// accept-all callback: until the application's own verification has
+/// passed, nothing about the peer is authenticated. The application must
+/// not write plaintext to the connection, and must not act on plaintext
+/// read from it, before then. (TLS 1.3 servers can send application data
+/// in their first flight; rustls buffers it, so it is only seen if the
+/// application chooses to read.)
+///
+/// A verifier callback that could park an in-progress handshake and resume
+/// it later would not need this trade-off, but rustls 0.19 drives
+/// verification synchronously from inside packet processing, with no way
+/// to suspend it.
+#[no_mangle]
+pub extern "C" fn rustls_client_config_builder_dangerous_set_deferred_certificate_verification(
+    config: *mut rustls_client_config_builder,
+) {
+    ffi_panic_boundary! {
+        let config: &mut ClientConfig = try_mut_from_ptr!(config);
+        config.dangerous().set_certificate_verifier(Arc::new(DeferredVerifier{}));
+    }
+}
+
 /// Use the trusted root certificates from the provided store.
 ///
 /// This replaces any trusted roots already configured with copies
@@ -377,6 +431,24 @@ pub extern "C" fn rustls_client_config_builder_set_enable_sni(
     }
 }
 
+/// Enable or disable sending TLS 1.3 early data ("0-RTT data") when
+/// resuming a session whose server offered it. Disabled by default.
+/// After the config is built, use rustls_client_connection_write_early_data
+/// to send data in the first flight, and
+/// rustls_client_connection_is_early_data_accepted to learn whether the
+/// server processed it.
+/// https://docs.rs/rustls/0.19.0/rustls/struct.ClientConfig.html#structfield.enable_early_data
+#[no_mangle]
+pub extern "C" fn rustls_client_config_builder_set_enable_early_data(
+    config: *mut rustls_client_config_builder,
+    enable: bool,
+) {
+    ffi_panic_boundary! {
+        let config: &mut ClientConfig = try_mut_from_ptr!(config);
+        config.enable_early_data = enable;
+    }
+}
+
 /// Set the cipher suite list, in preference order. The `ciphersuites`
 /// parameter must point to an array containing `len` pointers to
 /// `rustls_supported_ciphersuite` previously obtained from
@@ -542,6 +614,156 @@ pub extern "C" fn rustls_client_connection_new(
     }
 }
 
+/// A hostname that has been validated as a DNS name, ready for use as the
+/// server name in client connections. Building one performs the same UTF-8
+/// and DNS syntax checks as rustls_client_connection_new; connections made
+/// with rustls_client_connection_new_with_name then skip those checks
+/// entirely. Useful when dialing the same hostname many times.
+/// Under the hood, this object corresponds to a webpki::DNSName.
+pub struct rustls_dns_name {
+    // We use the opaque struct pattern to tell C about our types without
+    // telling them what's inside.
+    // https://doc.rust-lang.org/nomicon/ffi.html#representing-opaque-structs
+    _private: [u8; 0],
+}
+
+impl CastPtr for rustls_dns_name {
+    type RustType = webpki::DNSName;
+}
+
+/// Parse and validate `hostname` as a DNS name, storing the result in the
+/// output parameter `name_out`. `hostname` must be a NUL-terminated string.
+/// Returns RUSTLS_RESULT_INVALID_DNS_NAME_ERROR if the hostname is not
+/// valid UTF-8 or not a syntactically valid DNS name (for instance, an IP
+/// address). On success, the caller owns the rustls_dns_name and must call
+/// rustls_dns_name_free when done with it. A rustls_dns_name may be shared
+/// across any number of rustls_client_connection_new_with_name calls.
+#[no_mangle]
+pub extern "C" fn rustls_dns_name_new(
+    hostname: *const c_char,
+    name_out: *mut *const rustls_dns_name,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let hostname: &CStr = unsafe {
+            if hostname.is_null() {
+                return NullParameter;
+            }
+            CStr::from_ptr(hostname)
+        };
+        if name_out.is_null() {
+            return NullParameter;
+        }
+        let hostname: &str = match hostname.to_str() {
+            Ok(s) => s,
+            Err(std::str::Utf8Error { .. }) => return rustls_result::InvalidDnsNameError,
+        };
+        let name_ref = match webpki::DNSNameRef::try_from_ascii_str(hostname) {
+            Ok(nr) => nr,
+            Err(webpki::InvalidDNSNameError { .. }) => return rustls_result::InvalidDnsNameError,
+        };
+        unsafe {
+            *name_out = Box::into_raw(Box::new(name_ref.to_owned())) as *const _;
+        }
+        rustls_result::Ok
+    }
+}
+
+/// Free a rustls_dns_name previously returned from rustls_dns_name_new.
+/// Calling with NULL is fine. Must not be called twice with the same value.
+#[no_mangle]
+pub extern "C" fn rustls_dns_name_free(name: *const rustls_dns_name) {
+    ffi_panic_boundary! {
+        let name: &webpki::DNSName = try_ref_from_ptr!(name);
+        // Convert the pointer to a Box and drop it.
+        unsafe { Box::from_raw(name as *const webpki::DNSName as *mut webpki::DNSName); }
+    }
+}
+
+/// Create a new rustls_connection containing a client connection, like
+/// rustls_client_connection_new, but take the server name as a
+/// prevalidated rustls_dns_name instead of a string. No parsing or
+/// validation happens on this path; all of it was done once in
+/// rustls_dns_name_new. The caller keeps ownership of `name` and may
+/// reuse it for further connections.
+#[no_mangle]
+pub extern "C" fn rustls_client_connection_new_with_name(
+    config: *const rustls_client_config,
+    name: *const rustls_dns_name,
+    conn_out: *mut *mut rustls_connection,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let name: &webpki::DNSName = try_ref_from_ptr!(name);
+        let config: Arc<ClientConfig> = unsafe {
+            match (config as *const ClientConfig).as_ref() {
+                Some(c) => arc_with_incref_from_raw(c),
+                None => return NullParameter,
+            }
+        };
+
+        // We've succeeded. Put the client on the heap, and transfer ownership
+        // to the caller. After this point, we must return CRUSTLS_OK so the
+        // caller knows it is responsible for this memory.
+        let c = Connection::from_client(ClientSession::new(&config, name.as_ref()));
+        unsafe {
+            *conn_out = Box::into_raw(Box::new(c)) as *mut _;
+        }
+
+        return rustls_result::Ok;
+    }
+}
+
+/// Write up to `count` plaintext bytes from `buf` as TLS 1.3 early data
+/// ("0-RTT data"), before the handshake has completed. On success, store
+/// the number of bytes actually written in *out_n. A success with *out_n
+/// set to 0 means early data cannot be sent on this connection: it is not
+/// a client connection, early data was not enabled on the config (see
+/// rustls_client_config_builder_set_enable_early_data), the session being
+/// resumed did not offer early data, the first flight has already gone
+/// out, or the server's early data size limit has been reached. In that
+/// case, send the bytes with rustls_connection_write once the handshake
+/// completes.
+///
+/// Even after sending, the server may discard the early data. After the
+/// handshake, check rustls_client_connection_is_early_data_accepted: if
+/// it returns false, everything written with this function must be
+/// retransmitted with rustls_connection_write.
+#[no_mangle]
+pub extern "C" fn rustls_client_connection_write_early_data(
+    conn: *mut rustls_connection,
+    buf: *const u8,
+    count: size_t,
+    out_n: *mut size_t,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        let write_buf: &[u8] = try_slice!(buf, count);
+        let out_n: &mut size_t = try_mut_from_ptr!(out_n);
+        let n_written: usize = match conn.write_early_data(write_buf) {
+            Some(Ok(n)) => n,
+            Some(Err(_)) => return rustls_result::Io,
+            None => 0,
+        };
+        *out_n = n_written;
+        rustls_result::Ok
+    }
+}
+
+/// Returns true if the server signalled it will process early data sent
+/// with rustls_client_connection_write_early_data. Only meaningful once
+/// the handshake has completed; returns false for server connections.
+#[no_mangle]
+pub extern "C" fn rustls_client_connection_is_early_data_accepted(
+    conn: *const rustls_connection,
+) -> bool {
+    ffi_panic_boundary! {
+        let conn: &Connection = try_ref_from_ptr!(conn);
+        match conn.as_client() {
+            Some(c) => c.is_early_data_accepted(),
+            None => false,
+        }
+    }
+}
+
 /// Register callbacks for persistence of TLS session data. This means either
 /// session IDs (TLSv1.2) or . Both
 /// keys and values are highly sensitive data, containing enough information
@@ -1,12 +1,16 @@
+use std::time::{Duration, Instant};
 use std::{ffi::c_void, ptr::null};
 use std::{ptr::null_mut, slice};
 
 use libc::{size_t, EIO};
 use rustls::{Certificate, ClientSession, ServerSession, Session, SupportedCipherSuite};
 
+use std::io::{IoSlice, IoSliceMut, Read, Write};
+
 use crate::io::{
-    rustls_write_vectored_callback, CallbackReader, CallbackWriter, ReadCallback,
-    VectoredCallbackWriter, VectoredWriteCallback, WriteCallback,
+    rustls_iovec, rustls_read_vectored_callback, rustls_write_vectored_callback, CallbackReader,
+    CallbackWriter, ReadCallback, VectoredCallbackReader, VectoredCallbackWriter,
+    VectoredReadCallback, VectoredWriteCallback, WriteCallback,
 };
 use crate::is_close_notify;
 use crate::log::{ensure_log_registered, rustls_log_callback};
@@ -16,15 +20,53 @@ use crate::{
     io::{rustls_read_callback, rustls_write_callback},
     try_callback, try_mut_slice,
 };
-use crate::{ffi_panic_boundary, try_ref_from_ptr};
+use crate::{ffi_hot_path_boundary, ffi_panic_boundary, try_ref_from_ptr};
 use crate::{try_mut_from_ptr, try_slice, userdata_push, CastPtr};
 use rustls_result::NullParameter;
 
+/// Chunk size used when draining plaintext into the connection-owned
+/// buffer for rustls_connection_read_borrowed. Matches the maximum
+/// plaintext size of a TLS record.
+const PLAINTEXT_CHUNK_SIZE: usize = 16 * 1024;
+
+/// Upper bound on the TLS bytes staged by rustls_connection_read_tls_vectored
+/// while waiting for the session to accept them.
+const TLS_STAGING_SIZE: usize = 64 * 1024;
+
+/// Counters for rustls_connection_get_stats, updated on the existing I/O
+/// paths. All of this is cheap enough to maintain unconditionally.
+struct Stats {
+    tls_bytes_read: u64,
+    tls_bytes_written: u64,
+    plaintext_bytes_read: u64,
+    plaintext_bytes_written: u64,
+    created: Instant,
+    handshake_duration: Option<Duration>,
+}
+
+impl Stats {
+    fn new() -> Self {
+        Stats {
+            tls_bytes_read: 0,
+            tls_bytes_written: 0,
+            plaintext_bytes_read: 0,
+            plaintext_bytes_written: 0,
+            created: Instant::now(),
+            handshake_duration: None,
+        }
+    }
+}
+
 pub(crate) struct Connection {
     conn: Inner,
     userdata: *mut c_void,
     log_callback: rustls_log_callback,
+    log_level: Option<usize>,
     peer_certs: Option<Vec<Certificate>>,
+    plaintext_buf: Vec<u8>,
+    tls_in_buf: Vec<u8>,
+    tls_out_buf: Vec<u8>,
+    stats: Stats,
 }
 
 enum Inner {
@@ -38,7 +80,12 @@ impl Connection {
             conn: Inner::Client(s),
             userdata: null_mut(),
             log_callback: None,
+            log_level: None,
             peer_certs: None,
+            plaintext_buf: Vec::new(),
+            tls_in_buf: Vec::new(),
+            tls_out_buf: Vec::new(),
+            stats: Stats::new(),
         }
     }
 
@@ -47,11 +94,125 @@ impl Connection {
             conn: Inner::Server(s),
             userdata: null_mut(),
             log_callback: None,
+            log_level: None,
             peer_certs: None,
+            plaintext_buf: Vec::new(),
+            tls_in_buf: Vec::new(),
+            tls_out_buf: Vec::new(),
+            stats: Stats::new(),
         }
     }
 
-    #[allow(dead_code)]
+    /// Feed as many bytes from `tls_in_buf` into the session as it will
+    /// accept, retaining any unconsumed tail for a later call. The session
+    /// stops accepting bytes when its internal buffers are full, which
+    /// resolves once process_new_packets is called.
+    fn feed_staged_tls(&mut self) {
+        let session: &mut dyn Session = match &mut self.conn {
+            Inner::Client(c) => c,
+            Inner::Server(s) => s,
+        };
+        let mut pos = 0;
+        while pos < self.tls_in_buf.len() {
+            let mut remaining: &[u8] = &self.tls_in_buf[pos..];
+            match session.read_tls(&mut remaining) {
+                Ok(0) | Err(_) => break,
+                Ok(n) => pos += n,
+            }
+        }
+        self.tls_in_buf.drain(..pos);
+        self.stats.tls_bytes_read += pos as u64;
+    }
+
+    /// Replace the contents of `plaintext_buf` with all plaintext currently
+    /// available on the session. If a close_notify alert arrives after some
+    /// plaintext was read, the plaintext is kept and the alert is left for
+    /// the next call to report.
+    fn fill_plaintext_buf(&mut self) -> std::io::Result<()> {
+        let session: &mut dyn Session = match &mut self.conn {
+            Inner::Client(c) => c,
+            Inner::Server(s) => s,
+        };
+        let buf = &mut self.plaintext_buf;
+        buf.clear();
+        loop {
+            let filled = buf.len();
+            buf.resize(filled + PLAINTEXT_CHUNK_SIZE, 0);
+            match session.read(&mut buf[filled..]) {
+                Ok(0) => {
+                    buf.truncate(filled);
+                    return Ok(());
+                }
+                Ok(n) => buf.truncate(filled + n),
+                Err(e) => {
+                    buf.truncate(filled);
+                    if filled > 0 && is_close_notify(&e) {
+                        return Ok(());
+                    }
+                    return Err(e);
+                }
+            }
+        }
+    }
+
+    /// Prepare this connection for reuse with a fresh server session.
+    /// Everything tied to the previous peer is cleared, but the internal
+    /// buffers keep their allocated capacity.
+    pub(crate) fn reset_server(&mut self, s: ServerSession) {
+        self.conn = Inner::Server(s);
+        self.userdata = null_mut();
+        self.log_callback = None;
+        self.log_level = None;
+        self.peer_certs = None;
+        self.plaintext_buf.clear();
+        self.tls_in_buf.clear();
+        self.tls_out_buf.clear();
+        self.stats = Stats::new();
+    }
+
+    /// Move all TLS bytes the session has queued for sending into
+    /// `tls_out_buf`, so their exact count is known. The write_tls family
+    /// of functions serves bytes from this buffer before asking the
+    /// session for more, so callers see the same byte stream either way.
+    /// The buffer stays empty (and this is free) unless
+    /// rustls_connection_tls_bytes_buffered is used.
+    fn stage_outgoing(&mut self) {
+        let session: &mut dyn Session = match &mut self.conn {
+            Inner::Client(c) => c,
+            Inner::Server(s) => s,
+        };
+        while session.wants_write() {
+            // Writing to a Vec cannot fail or make partial progress.
+            if session.write_tls(&mut self.tls_out_buf).is_err() {
+                break;
+            }
+        }
+    }
+
+    /// Record the handshake completion time, once. Called after packet
+    /// processing, which is the only place a handshake makes progress.
+    fn note_handshake_done(&mut self) {
+        if self.stats.handshake_duration.is_none() && !self.as_ref().is_handshaking() {
+            self.stats.handshake_duration = Some(self.stats.created.elapsed());
+        }
+    }
+
+    /// Send TLS 1.3 early data, if the session is in a state that allows
+    /// it. Returns None when it is not: this is not a client connection,
+    /// early data is not enabled on the config, no suitable session is
+    /// being resumed, or the first flight has already gone out.
+    pub(crate) fn write_early_data(&mut self, buf: &[u8]) -> Option<std::io::Result<usize>> {
+        let result = {
+            let client = self.as_client_mut()?;
+            let mut early = client.early_data()?;
+            early.write(buf)
+        };
+        if let Ok(n) = result {
+            self.stats.plaintext_bytes_written += n as u64;
+        }
+        Some(result)
+    }
+
     pub(crate) fn as_client(&self) -> Option<&ClientSession> {
         match &self.conn {
             Inner::Client(c) => Some(c),
@@ -66,7 +227,6 @@ impl Connection {
         }
     }
 
-    #[allow(dead_code)]
     pub(crate) fn as_client_mut(&mut self) -> Option<&mut ClientSession> {
         match &mut self.conn {
             Inner::Client(c) => Some(c),
@@ -134,6 +294,21 @@ pub extern "C" fn rustls_connection_set_log_callback(
     conn.log_callback = cb;
 }
 
+/// Set the maximum log level delivered to this connection's log callback.
+/// Levels are the same as in rustls_log_params: 1 = error through
+/// 5 = trace; 0 silences logging for this connection. Records above the
+/// maximum are dropped inside the library with a single integer compare,
+/// before the message is formatted, so filtered levels cost nothing on
+/// the hot path. Connections without an explicit level use the
+/// process-wide default set with rustls_set_default_log_level.
+#[no_mangle]
+pub extern "C" fn rustls_connection_set_log_level(conn: *mut rustls_connection, level: size_t) {
+    ffi_panic_boundary! {
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        conn.log_level = Some(level);
+    }
+}
+
 /// Read some TLS bytes from the network into internal buffers. The actual network
 /// I/O is performed by `callback`, which you provide. Rustls will invoke your
 /// callback with a suitable buffer to store the read bytes into. You don't have
@@ -151,7 +326,7 @@ pub extern "C" fn rustls_connection_read_tls(
     userdata: *mut c_void,
     out_n: *mut size_t,
 ) -> rustls_io_result {
-    ffi_panic_boundary! {
+    ffi_hot_path_boundary! {
         let conn: &mut Connection = try_mut_from_ptr!(conn);
         let out_n: &mut size_t = try_mut_from_ptr!(out_n);
         let callback: ReadCallback = try_callback!(callback);
@@ -161,6 +336,95 @@ pub extern "C" fn rustls_connection_read_tls(
             Ok(n) => n,
             Err(e) => return rustls_io_result(e.raw_os_error().unwrap_or(EIO)),
         };
+        conn.stats.tls_bytes_read += n_read as u64;
+        *out_n = n_read;
+
+        rustls_io_result(0)
+    }
+}
+
+/// Read some TLS bytes from the network into internal buffers, like
+/// rustls_connection_read_tls, but invoke `callback` with multiple scattered
+/// buffers (readv-style) so that a full receive queue can be drained with a
+/// single syscall and a single FFI crossing. The TLS bytes delivered by the
+/// callback are staged in a buffer owned by the connection and fed to rustls
+/// from there; any bytes rustls does not accept immediately (because its
+/// internal buffers are full until the next
+/// rustls_connection_process_new_packets) are retained and fed on the next
+/// call. When the staging buffer is full, this sets *out_n to 0 and returns
+/// success; call rustls_connection_process_new_packets to make progress.
+/// The `userdata` parameter is passed through directly to `callback`. Note that
+/// this is distinct from the `userdata` parameter set with
+/// `rustls_connection_set_userdata`.
+/// Returns 0 for success, or an errno value on error. Passes through return values
+/// from callback. See rustls_read_vectored_callback for more details.
+#[no_mangle]
+pub extern "C" fn rustls_connection_read_tls_vectored(
+    conn: *mut rustls_connection,
+    callback: rustls_read_vectored_callback,
+    userdata: *mut c_void,
+    out_n: *mut size_t,
+) -> rustls_io_result {
+    ffi_hot_path_boundary! {
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        let out_n: &mut size_t = try_mut_from_ptr!(out_n);
+        let callback: VectoredReadCallback = try_callback!(callback);
+
+        // Feed TLS bytes retained from a previous call first, so the
+        // staging buffer offers the callback as much room as possible.
+        conn.feed_staged_tls();
+        let staged = conn.tls_in_buf.len();
+        let free = TLS_STAGING_SIZE.saturating_sub(staged);
+        if free == 0 {
+            *out_n = 0;
+            return rustls_io_result(0);
+        }
+        conn.tls_in_buf.resize(staged + free, 0);
+
+        let mut reader = VectoredCallbackReader { callback, userdata };
+        let n_read: usize =
+            match reader.read_vectored(&mut [IoSliceMut::new(&mut conn.tls_in_buf[staged..])]) {
+                Ok(n) => n,
+                Err(e) => {
+                    conn.tls_in_buf.truncate(staged);
+                    return rustls_io_result(e.raw_os_error().unwrap_or(EIO));
+                }
+            };
+        conn.tls_in_buf.truncate(staged + n_read);
+        conn.feed_staged_tls();
+        *out_n = n_read;
+
+        rustls_io_result(0)
+    }
+}
+
+/// Read up to `count` TLS bytes from `buf` into the connection's internal
+/// buffers, without any callback. This is for applications that perform the
+/// network I/O themselves (for instance with completion-based APIs like
+/// io_uring) and hold received TLS bytes in their own memory: it moves the
+/// bytes directly, with no function-pointer indirection on the hot path.
+/// On success, store the number of bytes consumed in *out_n (this may be
+/// less than `count` if the connection's internal buffers are full; call
+/// rustls_connection_process_new_packets and try again).
+/// Returns 0 for success, or an errno value on error.
+/// https://docs.rs/rustls/0.19.0/rustls/trait.Session.html#tymethod.read_tls
+#[no_mangle]
+pub extern "C" fn rustls_connection_read_tls_from_buf(
+    conn: *mut rustls_connection,
+    buf: *const u8,
+    count: size_t,
+    out_n: *mut size_t,
+) -> rustls_io_result {
+    ffi_hot_path_boundary! {
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        let mut read_buf: &[u8] = try_slice!(buf, count);
+        let out_n: &mut size_t = try_mut_from_ptr!(out_n);
+
+        let n_read: usize = match conn.as_mut().read_tls(&mut read_buf) {
+            Ok(n) => n,
+            Err(e) => return rustls_io_result(e.raw_os_error().unwrap_or(EIO)),
+        };
+        conn.stats.tls_bytes_read += n_read as u64;
         *out_n = n_read;
 
         rustls_io_result(0)
@@ -184,16 +448,29 @@ pub extern "C" fn rustls_connection_write_tls(
     userdata: *mut c_void,
     out_n: *mut size_t,
 ) -> rustls_io_result {
-    ffi_panic_boundary! {
+    ffi_hot_path_boundary! {
         let conn: &mut Connection = try_mut_from_ptr!(conn);
         let out_n: &mut size_t = try_mut_from_ptr!(out_n);
         let callback: WriteCallback = try_callback!(callback);
 
         let mut writer = CallbackWriter { callback, userdata };
-        let n_written: usize = match conn.as_mut().write_tls(&mut writer) {
-            Ok(n) => n,
-            Err(e) => return rustls_io_result(e.raw_os_error().unwrap_or(EIO)),
+        let n_written: usize = if !conn.tls_out_buf.is_empty() {
+            // Serve bytes staged by rustls_connection_tls_bytes_buffered
+            // before asking the session for more.
+            match writer.write(&conn.tls_out_buf) {
+                Ok(n) => {
+                    conn.tls_out_buf.drain(..n);
+                    n
+                }
+                Err(e) => return rustls_io_result(e.raw_os_error().unwrap_or(EIO)),
+            }
+        } else {
+            match conn.as_mut().write_tls(&mut writer) {
+                Ok(n) => n,
+                Err(e) => return rustls_io_result(e.raw_os_error().unwrap_or(EIO)),
+            }
         };
+        conn.stats.tls_bytes_written += n_written as u64;
         *out_n = n_written;
 
         rustls_io_result(0)
@@ -217,16 +494,72 @@ pub extern "C" fn rustls_connection_write_tls_vectored(
     userdata: *mut c_void,
     out_n: *mut size_t,
 ) -> rustls_io_result {
-    ffi_panic_boundary! {
+    ffi_hot_path_boundary! {
         let conn: &mut Connection = try_mut_from_ptr!(conn);
         let out_n: &mut size_t = try_mut_from_ptr!(out_n);
         let callback: VectoredWriteCallback = try_callback!(callback);
 
         let mut writer = VectoredCallbackWriter { callback, userdata };
-        let n_written: usize = match conn.as_mut().write_tls(&mut writer) {
-            Ok(n) => n,
-            Err(e) => return rustls_io_result(e.raw_os_error().unwrap_or(EIO)),
+        let n_written: usize = if !conn.tls_out_buf.is_empty() {
+            // Serve bytes staged by rustls_connection_tls_bytes_buffered
+            // before asking the session for more.
+            match writer.write(&conn.tls_out_buf) {
+                Ok(n) => {
+                    conn.tls_out_buf.drain(..n);
+                    n
+                }
+                Err(e) => return rustls_io_result(e.raw_os_error().unwrap_or(EIO)),
+            }
+        } else {
+            match conn.as_mut().write_tls(&mut writer) {
+                Ok(n) => n,
+                Err(e) => return rustls_io_result(e.raw_os_error().unwrap_or(EIO)),
+            }
         };
+        conn.stats.tls_bytes_written += n_written as u64;
+        *out_n = n_written;
+
+        rustls_io_result(0)
+    }
+}
+
+/// Write up to `count` TLS bytes that the connection has queued for sending
+/// into `buf`, without any callback. This is the counterpart to
+/// rustls_connection_read_tls_from_buf for applications that perform the
+/// network I/O themselves: the TLS bytes are moved directly into
+/// caller-provided memory and can then be sent however the application
+/// chooses (including with completion-based APIs like io_uring).
+/// On success, store the number of bytes written in *out_n (this may be
+/// less than the number of queued bytes; call again with more buffer space
+/// while rustls_connection_wants_write returns true).
+/// Returns 0 for success, or an errno value on error.
+/// https://docs.rs/rustls/0.19.0/rustls/trait.Session.html#tymethod.write_tls
+#[no_mangle]
+pub extern "C" fn rustls_connection_write_tls_into_buf(
+    conn: *mut rustls_connection,
+    buf: *mut u8,
+    count: size_t,
+    out_n: *mut size_t,
+) -> rustls_io_result {
+    ffi_hot_path_boundary! {
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        let mut write_buf: &mut [u8] = try_mut_slice!(buf, count);
+        let out_n: &mut size_t = try_mut_from_ptr!(out_n);
+
+        let n_written: usize = if !conn.tls_out_buf.is_empty() {
+            // Serve bytes staged by rustls_connection_tls_bytes_buffered
+            // before asking the session for more.
+            let n = std::cmp::min(write_buf.len(), conn.tls_out_buf.len());
+            write_buf[..n].copy_from_slice(&conn.tls_out_buf[..n]);
+            conn.tls_out_buf.drain(..n);
+            n
+        } else {
+            match conn.as_mut().write_tls(&mut write_buf) {
+                Ok(n) => n,
+                Err(e) => return rustls_io_result(e.raw_os_error().unwrap_or(EIO)),
+            }
+        };
+        conn.stats.tls_bytes_written += n_written as u64;
         *out_n = n_written;
 
         rustls_io_result(0)
@@ -237,9 +570,13 @@ pub extern "C" fn rustls_connection_write_tls_vectored(
 pub extern "C" fn rustls_connection_process_new_packets(
     conn: *mut rustls_connection,
 ) -> rustls_result {
-    ffi_panic_boundary! {
+    ffi_hot_path_boundary! {
         let conn: &mut Connection = try_mut_from_ptr!(conn);
-        let guard = match userdata_push(conn.userdata, conn.log_callback) {
+        let guard = match userdata_push(
+            conn.userdata,
+            conn.log_callback,
+            conn.log_level.unwrap_or_else(crate::log::default_log_level),
+        ) {
             Ok(g) => g,
             Err(_) => return rustls_result::Panic,
         };
@@ -247,6 +584,7 @@ pub extern "C" fn rustls_connection_process_new_packets(
             Ok(()) => rustls_result::Ok,
             Err(e) => map_error(e),
         };
+        conn.note_handshake_done();
         match guard.try_drop() {
             Ok(()) => result,
             Err(_) => return rustls_result::Panic,
@@ -254,9 +592,56 @@ pub extern "C" fn rustls_connection_process_new_packets(
     }
 }
 
+/// Process new packets on each of `count` connections in a single call,
+/// storing the per-connection result in the corresponding element of
+/// `out_results`. This is equivalent to calling
+/// rustls_connection_process_new_packets on each connection in turn, but an
+/// event loop waking up with many readable connections pays the FFI
+/// transition only once for the whole batch. A NULL connection in `conns`
+/// gets RUSTLS_RESULT_NULL_PARAMETER in its result slot and the batch
+/// continues. The function's own return value only reports problems with
+/// the arrays themselves; check the individual results for TLS errors.
+#[no_mangle]
+pub extern "C" fn rustls_connections_process_batch(
+    conns: *const *mut rustls_connection,
+    count: size_t,
+    out_results: *mut rustls_result,
+) -> rustls_result {
+    ffi_hot_path_boundary! {
+        let conns: &[*mut rustls_connection] = try_slice!(conns, count);
+        let out_results: &mut [rustls_result] = try_mut_slice!(out_results, count);
+        for (conn, out) in conns.iter().zip(out_results.iter_mut()) {
+            let conn: &mut Connection = match crate::try_from_mut(*conn) {
+                Some(c) => c,
+                None => {
+                    *out = NullParameter;
+                    continue;
+                }
+            };
+            let guard = match userdata_push(
+            conn.userdata,
+            conn.log_callback,
+            conn.log_level.unwrap_or_else(crate::log::default_log_level),
+        ) {
+                Ok(g) => g,
+                Err(_) => return rustls_result::Panic,
+            };
+            *out = match conn.as_mut().process_new_packets() {
+                Ok(()) => rustls_result::Ok,
+                Err(e) => map_error(e),
+            };
+            conn.note_handshake_done();
+            if guard.try_drop().is_err() {
+                return rustls_result::Panic;
+            }
+        }
+        rustls_result::Ok
+    }
+}
+
 #[no_mangle]
 pub extern "C" fn rustls_connection_wants_read(conn: *const rustls_connection) -> bool {
-    ffi_panic_boundary! {
+    ffi_hot_path_boundary! {
         let conn: &Connection = try_ref_from_ptr!(conn);
         conn.as_ref().wants_read()
     }
@@ -264,20 +649,72 @@ pub extern "C" fn rustls_connection_wants_read(conn: *const rustls_connection) -
 
 #[no_mangle]
 pub extern "C" fn rustls_connection_wants_write(conn: *const rustls_connection) -> bool {
-    ffi_panic_boundary! {
+    ffi_hot_path_boundary! {
         let conn: &Connection = try_ref_from_ptr!(conn);
-        conn.as_ref().wants_write()
+        !conn.tls_out_buf.is_empty() || conn.as_ref().wants_write()
+    }
+}
+
+/// Return the exact number of TLS bytes this connection has queued for
+/// sending. Where rustls_connection_wants_write is a single bit, this lets
+/// an event loop prioritize draining heavily backlogged connections and
+/// apply backpressure proportionally. To get an exact count, the queued
+/// bytes are moved into a buffer owned by the connection; the write_tls
+/// family of functions drains that buffer first, so the byte stream the
+/// application sees is unchanged. Connections that never call this
+/// function do not pay for the extra buffering.
+#[no_mangle]
+pub extern "C" fn rustls_connection_tls_bytes_buffered(conn: *mut rustls_connection) -> size_t {
+    ffi_hot_path_boundary! {
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        conn.stage_outgoing();
+        conn.tls_out_buf.len()
     }
 }
 
 #[no_mangle]
 pub extern "C" fn rustls_connection_is_handshaking(conn: *const rustls_connection) -> bool {
-    ffi_panic_boundary! {
+    ffi_hot_path_boundary! {
         let conn: &Connection = try_ref_from_ptr!(conn);
         conn.as_ref().is_handshaking()
     }
 }
 
+/// Pre-size the buffers this connection uses, the counterpart to capping
+/// them with rustls_connection_set_buffer_limit. Buffers start empty and
+/// grow on demand, so a connection that is about to move a lot of data
+/// pays a staircase of reallocations as they warm up; a connection that
+/// is known to, say, serve 16 MB responses can instead reserve once up
+/// front. `recv_hint` is applied to the receive-path buffers (staged TLS
+/// input and gathered plaintext), `send_hint` to the staged TLS output
+/// buffer. Hints only ever grow capacity, never shrink it, and either may
+/// be 0 to leave that side alone. Connections recycled through a
+/// rustls_connection_pool keep their capacity, so in a pool the cost is
+/// paid once per slot.
+///
+/// rustls' own deframer and sendable buffers cannot be pre-sized through
+/// the rustls 0.19 API; the hints cover the buffers this library adds on
+/// the same paths.
+#[no_mangle]
+pub extern "C" fn rustls_connection_set_initial_buffer_size(
+    conn: *mut rustls_connection,
+    recv_hint: size_t,
+    send_hint: size_t,
+) {
+    ffi_panic_boundary! {
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        fn grow(buf: &mut Vec<u8>, hint: usize) {
+            if hint > buf.capacity() {
+                let len = buf.len();
+                buf.reserve(hint - len);
+            }
+        }
+        grow(&mut conn.tls_in_buf, recv_hint);
+        grow(&mut conn.plaintext_buf, recv_hint);
+        grow(&mut conn.tls_out_buf, send_hint);
+    }
+}
+
 /// Sets a limit on the internal buffers used to buffer unsent plaintext (prior
 /// to completing the TLS handshake) and unsent TLS records. By default, there
 /// is no limit. The limit can be set at any time, even if the current buffer
@@ -396,6 +833,43 @@ pub extern "C" fn rustls_connection_get_negotiated_ciphersuite(
     }
 }
 
+/// Derive `count` bytes of keying material from the connection's master
+/// secret, as described in RFC 5705, and write them to `buf`. `label` (of
+/// `label_len` bytes) disambiguates between uses; `context` may be NULL for
+/// no context, which is distinct from an empty (zero-length) context.
+/// This fails until the handshake is complete.
+///
+/// Note that rustls does not expose the negotiated traffic keys, IVs or
+/// record sequence numbers themselves, so a kernel TLS offload handoff is
+/// not possible with this release; exported keying material is the
+/// supported way to bind other protocols to the TLS session.
+/// https://docs.rs/rustls/0.19.0/rustls/trait.Session.html#tymethod.export_keying_material
+#[no_mangle]
+pub extern "C" fn rustls_connection_export_keying_material(
+    conn: *const rustls_connection,
+    label: *const u8,
+    label_len: size_t,
+    context: *const u8,
+    context_len: size_t,
+    buf: *mut u8,
+    count: size_t,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let conn: &Connection = try_ref_from_ptr!(conn);
+        let label: &[u8] = try_slice!(label, label_len);
+        let context: Option<&[u8]> = if context.is_null() {
+            None
+        } else {
+            Some(unsafe { slice::from_raw_parts(context, context_len as usize) })
+        };
+        let buf: &mut [u8] = try_mut_slice!(buf, count);
+        match conn.as_ref().export_keying_material(buf, label, context) {
+            Ok(()) => rustls_result::Ok,
+            Err(e) => map_error(e),
+        }
+    }
+}
+
 /// Write up to `count` plaintext bytes from `buf` into the `rustls_connection`.
 /// This will increase the number of output bytes available to
 /// `rustls_connection_write_tls`.
@@ -408,7 +882,7 @@ pub extern "C" fn rustls_connection_write(
     count: size_t,
     out_n: *mut size_t,
 ) -> rustls_result {
-    ffi_panic_boundary! {
+    ffi_hot_path_boundary! {
         let conn: &mut Connection = try_mut_from_ptr!(conn);
         let write_buf: &[u8] = try_slice!(buf, count);
         let out_n: &mut size_t = unsafe {
@@ -421,6 +895,42 @@ pub extern "C" fn rustls_connection_write(
             Ok(n) => n,
             Err(_) => return rustls_result::Io,
         };
+        conn.stats.plaintext_bytes_written += n_written as u64;
+        *out_n = n_written;
+        rustls_result::Ok
+    }
+}
+
+/// Write plaintext bytes from the `count` iovecs in `iov` into the
+/// `rustls_connection`, in order. This is the writev-style counterpart to
+/// rustls_connection_write: rustls packs the fragments into TLS records
+/// directly, so callers with e.g. a header buffer and a body buffer don't
+/// have to coalesce them into one contiguous buffer first.
+/// On success, store the total number of bytes written in *out_n (this may
+/// be less than the sum of the iovec lengths).
+#[no_mangle]
+pub extern "C" fn rustls_connection_write_vectored(
+    conn: *mut rustls_connection,
+    iov: *const rustls_iovec,
+    count: size_t,
+    out_n: *mut size_t,
+) -> rustls_result {
+    ffi_hot_path_boundary! {
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        let out_n: &mut size_t = try_mut_from_ptr!(out_n);
+        if iov.is_null() {
+            return NullParameter;
+        }
+        let iov: &[IoSlice] = unsafe {
+            // This cast is sound because IoSlice is documented to be
+            // ABI-compatible with iovec on Unix, and with WSABUF on Windows.
+            slice::from_raw_parts(iov as *const IoSlice, count as usize)
+        };
+        let n_written: usize = match conn.as_mut().write_vectored(iov) {
+            Ok(n) => n,
+            Err(_) => return rustls_result::Io,
+        };
+        conn.stats.plaintext_bytes_written += n_written as u64;
         *out_n = n_written;
         rustls_result::Ok
     }
@@ -444,7 +954,7 @@ pub extern "C" fn rustls_connection_read(
     count: size_t,
     out_n: *mut size_t,
 ) -> rustls_result {
-    ffi_panic_boundary! {
+    ffi_hot_path_boundary! {
         let conn: &mut Connection = try_mut_from_ptr!(conn);
         let read_buf: &mut [u8] = try_mut_slice!(buf, count);
         let out_n: &mut size_t = try_mut_from_ptr!(out_n);
@@ -458,11 +968,101 @@ pub extern "C" fn rustls_connection_read(
             }
             Err(_) => return rustls_result::Io,
         };
+        conn.stats.plaintext_bytes_read += n_read as u64;
         *out_n = n_read;
         rustls_result::Ok
     }
 }
 
+/// Read all plaintext bytes currently available on the `rustls_connection`
+/// and provide access to them without copying them into a caller-provided
+/// buffer. On success, `*out_data` and `*out_n` are set to a borrowed view
+/// of the available bytes. The view is only valid until the next call to
+/// `rustls_connection_read`, `rustls_connection_read_borrowed`,
+/// `rustls_connection_process_new_packets`, or `rustls_connection_free` on
+/// this connection. The caller must copy any bytes it wants to keep longer.
+/// A success with *out_n set to 0 means "all bytes currently available have
+/// been read, but more bytes may become available after subsequent calls to
+/// rustls_connection_read_tls and rustls_connection_process_new_packets."
+///
+/// Since rustls does not expose its internal plaintext buffers, the bytes
+/// are gathered into a buffer owned by the connection. Compared to
+/// `rustls_connection_read` this saves the copy into (pre-initialized)
+/// caller memory, and allows parsing the plaintext in place.
+#[no_mangle]
+pub extern "C" fn rustls_connection_read_borrowed(
+    conn: *mut rustls_connection,
+    out_data: *mut *const u8,
+    out_n: *mut size_t,
+) -> rustls_result {
+    ffi_hot_path_boundary! {
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        let out_data: &mut *const u8 = try_mut_from_ptr!(out_data);
+        let out_n: &mut size_t = try_mut_from_ptr!(out_n);
+
+        match conn.fill_plaintext_buf() {
+            Ok(()) => {}
+            // Rustls turns close_notify alerts into `io::Error` of kind `ConnectionAborted`.
+            // https://docs.rs/rustls/0.19.0/rustls/struct.ClientSession.html#impl-Read.
+            Err(e) if is_close_notify(&e) => {
+                return rustls_result::AlertCloseNotify;
+            }
+            Err(_) => return rustls_result::Io,
+        }
+        conn.stats.plaintext_bytes_read += conn.plaintext_buf.len() as u64;
+        *out_data = conn.plaintext_buf.as_ptr();
+        *out_n = conn.plaintext_buf.len();
+        rustls_result::Ok
+    }
+}
+
+/// Point-in-time statistics for a connection, filled in by
+/// rustls_connection_get_stats. The byte counters cover everything that
+/// has crossed this API on the connection: TLS bytes via the read_tls and
+/// write_tls families, plaintext bytes via rustls_connection_read,
+/// rustls_connection_read_borrowed and rustls_connection_write.
+#[repr(C)]
+pub struct rustls_connection_stats {
+    pub tls_bytes_read: u64,
+    pub tls_bytes_written: u64,
+    pub plaintext_bytes_read: u64,
+    pub plaintext_bytes_written: u64,
+    /// Microseconds from the creation of the connection until its
+    /// handshake completed, or 0 while it is still handshaking.
+    pub handshake_duration_us: u64,
+}
+
+impl CastPtr for rustls_connection_stats {
+    type RustType = rustls_connection_stats;
+}
+
+/// Fill `out_stats` with the connection's current statistics. The
+/// underlying counters are bumped on the existing I/O paths as plain
+/// additions, so maintaining them costs close to nothing; this call just
+/// copies them out. May be called at any time, including after the
+/// connection has finished.
+#[no_mangle]
+pub extern "C" fn rustls_connection_get_stats(
+    conn: *const rustls_connection,
+    out_stats: *mut rustls_connection_stats,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let conn: &Connection = try_ref_from_ptr!(conn);
+        let out_stats: &mut rustls_connection_stats = try_mut_from_ptr!(out_stats);
+        *out_stats = rustls_connection_stats {
+            tls_bytes_read: conn.stats.tls_bytes_read,
+            tls_bytes_written: conn.stats.tls_bytes_written,
+            plaintext_bytes_read: conn.stats.plaintext_bytes_read,
+            plaintext_bytes_written: conn.stats.plaintext_bytes_written,
+            handshake_duration_us: match conn.stats.handshake_duration {
+                Some(d) => d.as_micros() as u64,
+                None => 0,
+            },
+        };
+        rustls_result::Ok
+    }
+}
+
 /// Free a rustls_connection. Calling with NULL is fine.
 /// Must not be called twice with the same value.
 #[no_mangle]
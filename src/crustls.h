@@ -119,6 +119,18 @@ typedef struct rustls_certificate rustls_certificate;
  */
 typedef struct rustls_certified_key rustls_certified_key;
 
+/**
+ * A mapping from DNS names to certified keys, for servers hosting many
+ * virtual hosts. Resolution during the handshake is a hash lookup on the
+ * SNI hostname (constant time in the number of entries), with support for
+ * single-label wildcard entries like "*.example.com". Fill the map with
+ * rustls_certified_key_map_insert, then install it on a server config
+ * builder with rustls_server_config_builder_set_key_map. This object is
+ * not safe for concurrent mutation. Under the hood, this object
+ * corresponds to a Box<CertifiedKeyMap>.
+ */
+typedef struct rustls_certified_key_map rustls_certified_key_map;
+
 /**
  * A verifier of client certificates that requires all certificates to be
  * trusted based on a given`rustls_root_cert_store`. Usable in building server
@@ -158,6 +170,26 @@ typedef struct rustls_client_config_builder rustls_client_config_builder;
 
 typedef struct rustls_connection rustls_connection;
 
+/**
+ * A pool of server connections sharing one rustls_server_config. Taking a
+ * connection from the pool reuses the heap allocations of a previously
+ * returned one, so a server accepting many short-lived connections does
+ * not pay for a fresh allocation on every accept. The pool is safe to
+ * share between threads. Under the hood, this object corresponds to a
+ * Box<ConnectionPool>.
+ */
+typedef struct rustls_connection_pool rustls_connection_pool;
+
+/**
+ * A hostname that has been validated as a DNS name, ready for use as the
+ * server name in client connections. Building one performs the same UTF-8
+ * and DNS syntax checks as rustls_client_connection_new; connections made
+ * with rustls_client_connection_new_with_name then skip those checks
+ * entirely. Useful when dialing the same hostname many times.
+ * Under the hood, this object corresponds to a webpki::DNSName.
+ */
+typedef struct rustls_dns_name rustls_dns_name;
+
 /**
  * An alias for `struct iovec` from uio.h (on Unix) or `WSABUF` on Windows. You should cast
  * `const struct rustls_iovec *` to `const struct iovec *` on Unix, or `const *LPWSABUF`
@@ -232,6 +264,17 @@ typedef struct rustls_slice_str rustls_slice_str;
  */
 typedef struct rustls_supported_ciphersuite rustls_supported_ciphersuite;
 
+/**
+ * A certified key whose OCSP response can be replaced while server
+ * configs are using the key. Handshakes pick up the current response at
+ * the time the certificate is resolved, so refreshing a staple is a
+ * pointer swap instead of a config rebuild. The object is safe for
+ * concurrent use; a swap does not affect handshakes already in flight.
+ * Under the hood, this object corresponds to an
+ * Arc<SwappableCertifiedKey>.
+ */
+typedef struct rustls_swappable_certified_key rustls_swappable_certified_key;
+
 /**
  * A read-only view on a Rust byte slice.
  *
@@ -369,6 +412,25 @@ typedef int rustls_io_result;
  */
 typedef rustls_io_result (*rustls_read_callback)(void *userdata, uint8_t *buf, size_t n, size_t *out_n);
 
+/**
+ * A callback for rustls_connection_read_tls_vectored.
+ * An implementation of this callback should attempt to read from the
+ * network into the given `count` iovecs, in order. If any bytes were read,
+ * the implementation should set out_n to the total number of bytes read and
+ * return 0. If there was an error, the implementation should return a
+ * nonzero rustls_io_result, which will be passed through to the caller.
+ * On POSIX systems, returning `errno` is convenient. On other systems, any
+ * appropriate error code works.
+ * It's best to make one read attempt to the network per call. Additional
+ * reads will be triggered by subsequent calls to one of the `_read_tls`
+ * methods.
+ * `userdata` is set to the value provided to `rustls_connection_set_userdata`.
+ * In most cases that should be a struct that contains, at a minimum, a file
+ * descriptor.
+ * The iov and out_n pointers are borrowed and should not be retained across calls.
+ */
+typedef rustls_io_result (*rustls_read_vectored_callback)(void *userdata, struct rustls_iovec *iov, size_t count, size_t *out_n);
+
 /**
  * A callback for rustls_server_session_write_tls or rustls_client_session_write_tls.
  * An implementation of this callback should attempt to write the `n` bytes in buf
@@ -401,6 +463,25 @@ typedef rustls_io_result (*rustls_write_callback)(void *userdata, const uint8_t
  */
 typedef rustls_io_result (*rustls_write_vectored_callback)(void *userdata, const struct rustls_iovec *iov, size_t count, size_t *out_n);
 
+/**
+ * Point-in-time statistics for a connection, filled in by
+ * rustls_connection_get_stats. The byte counters cover everything that
+ * has crossed this API on the connection: TLS bytes via the read_tls and
+ * write_tls families, plaintext bytes via rustls_connection_read,
+ * rustls_connection_read_borrowed and rustls_connection_write.
+ */
+typedef struct rustls_connection_stats {
+  uint64_t tls_bytes_read;
+  uint64_t tls_bytes_written;
+  uint64_t plaintext_bytes_read;
+  uint64_t plaintext_bytes_written;
+  /**
+   * Microseconds from the creation of the connection until its
+   * handshake completed, or 0 while it is still handshaking.
+   */
+  uint64_t handshake_duration_us;
+} rustls_connection_stats;
+
 /**
  * Any context information the callback will receive when invoked.
  */
@@ -525,6 +606,29 @@ enum rustls_result rustls_certified_key_build(const uint8_t *cert_chain,
                                               size_t private_key_len,
                                               const struct rustls_certified_key **certified_key_out);
 
+/**
+ * Build a `rustls_certified_key` from DER-encoded inputs, with no PEM
+ * decoding involved. `cert_chain` must point to `cert_chain_len`
+ * `rustls_slice_bytes`, each containing one DER-encoded certificate, with
+ * the end-entity certificate first. `private_key` must point to
+ * `private_key_len` bytes of DER (PKCS8 or RSA). This is useful when
+ * certificates are kept in a binary store (possibly memory-mapped):
+ * loading a large certificate inventory this way avoids the base64
+ * decoding cost of rustls_certified_key_build. All inputs are copied;
+ * the caller's buffers only need to live for the duration of the call.
+ *
+ * Like rustls_certified_key_build, this does not check the validity of
+ * the certificate chain; the consistency of the end-entity certificate
+ * is checked when the key is used in a config.
+ *
+ * For memory lifetime, see rustls_certified_key_build.
+ */
+enum rustls_result rustls_certified_key_build_der(const struct rustls_slice_bytes *cert_chain,
+                                                  size_t cert_chain_len,
+                                                  const uint8_t *private_key,
+                                                  size_t private_key_len,
+                                                  const struct rustls_certified_key **certified_key_out);
+
 /**
  * Return the i-th rustls_certificate in the rustls_certified_key. 0 gives the
  * end-entity certificate. 1 and higher give certificates from the chain.
@@ -556,6 +660,37 @@ enum rustls_result rustls_certified_key_clone_with_ocsp(const struct rustls_cert
  */
 void rustls_certified_key_free(const struct rustls_certified_key *key);
 
+/**
+ * Build a rustls_swappable_certified_key wrapping the given certified
+ * key. The swappable key holds a reference to `key`; the caller may free
+ * its own copy at any time. The returned pointer is reference-counted
+ * like a rustls_certified_key and must be freed with
+ * rustls_swappable_certified_key_free. If `key` is NULL, returns NULL.
+ */
+const struct rustls_swappable_certified_key *rustls_swappable_certified_key_new(const struct rustls_certified_key *key);
+
+/**
+ * Replace the OCSP response of the swappable key with the given DER
+ * encoded bytes, atomically publishing it to every config and resolver
+ * referencing the key. Pass NULL to clear any present OCSP data. The
+ * bytes are copied. This is the in-place counterpart of
+ * rustls_certified_key_clone_with_ocsp: an hourly staple refresh over a
+ * large certificate inventory is one cheap call per key, with no config
+ * rebuild and no connection draining.
+ */
+enum rustls_result rustls_swappable_certified_key_set_ocsp(const struct rustls_swappable_certified_key *key,
+                                                           const struct rustls_slice_bytes *ocsp_response);
+
+/**
+ * "Free" a rustls_swappable_certified_key previously returned from
+ * rustls_swappable_certified_key_new. Since it is actually an atomically
+ * reference-counted pointer, extant configs and resolvers may still hold
+ * an internal reference to the Rust object. However, C code must consider
+ * this pointer unusable after "free"ing it.
+ * Calling with NULL is fine. Must not be called twice with the same value.
+ */
+void rustls_swappable_certified_key_free(const struct rustls_swappable_certified_key *key);
+
 /**
  * Create a rustls_root_cert_store. Caller owns the memory and must
  * eventually call rustls_root_cert_store_free. The store starts out empty.
@@ -578,6 +713,36 @@ enum rustls_result rustls_root_cert_store_add_pem(struct rustls_root_cert_store
                                                   size_t pem_len,
                                                   bool strict);
 
+/**
+ * Serialize the root cert store into a compact binary format, copying it
+ * to `buf` which can hold up to `count` bytes, and storing the serialized
+ * length in `out_n`. If the serialized form is larger than `count`, stores
+ * the required size in `out_n` and returns
+ * RUSTLS_RESULT_INSUFFICIENT_SIZE without writing to `buf`.
+ *
+ * The blob can be written to a file once and then loaded by many worker
+ * processes with rustls_root_cert_store_add_serialized, which only has to
+ * do length-delimited copies: no PEM decoding or certificate parsing is
+ * repeated per process. The format is versioned but private to this
+ * library; do not parse it yourself.
+ */
+enum rustls_result rustls_root_cert_store_serialize(const struct rustls_root_cert_store *store,
+                                                    uint8_t *buf,
+                                                    size_t count,
+                                                    size_t *out_n);
+
+/**
+ * Add all trust anchors from a blob previously produced by
+ * rustls_root_cert_store_serialize. `data` may point into a memory-mapped
+ * file; the bytes are copied and need not stay valid after the call. A
+ * blob that was not produced by rustls_root_cert_store_serialize, or that
+ * is truncated or otherwise damaged, returns a CertificateParseError and
+ * leaves the store unchanged.
+ */
+enum rustls_result rustls_root_cert_store_add_serialized(struct rustls_root_cert_store *store,
+                                                         const uint8_t *data,
+                                                         size_t len);
+
 /**
  * "Free" a rustls_root_cert_store previously returned from
  * rustls_root_cert_store_builder_build. Since rustls_root_cert_store is actually an
@@ -683,6 +848,34 @@ const struct rustls_client_config *rustls_client_config_builder_build(struct rus
 void rustls_client_config_builder_dangerous_set_certificate_verifier(struct rustls_client_config_builder *config,
                                                                      rustls_verify_server_cert_callback callback);
 
+/**
+ * Defer certificate verification to the application, after the handshake.
+ *
+ * With this set, the handshake completes without the certificate chain
+ * being verified, so slow checks (revocation lookups against a local
+ * database, CT verification, and so on) no longer run on - and stall -
+ * the thread driving rustls_connection_process_new_packets. Instead, once
+ * rustls_connection_is_handshaking returns false, the application must
+ * retrieve the chain with rustls_connection_get_peer_certificate and
+ * verify it on whatever thread it likes, and must close the connection if
+ * verification fails.
+ *
+ * This is dangerous in the same way as
+ * rustls_client_config_builder_dangerous_set_certificate_verifier with an
+ * accept-all callback: until the application's own verification has
+ * passed, nothing about the peer is authenticated. The application must
+ * not write plaintext to the connection, and must not act on plaintext
+ * read from it, before then. (TLS 1.3 servers can send application data
+ * in their first flight; rustls buffers it, so it is only seen if the
+ * application chooses to read.)
+ *
+ * A verifier callback that could park an in-progress handshake and resume
+ * it later would not need this trade-off, but rustls 0.19 drives
+ * verification synchronously from inside packet processing, with no way
+ * to suspend it.
+ */
+void rustls_client_config_builder_dangerous_set_deferred_certificate_verification(struct rustls_client_config_builder *config);
+
 /**
  * Use the trusted root certificates from the provided store.
  *
@@ -739,6 +932,18 @@ enum rustls_result rustls_client_config_builder_set_protocols(struct rustls_clie
 void rustls_client_config_builder_set_enable_sni(struct rustls_client_config_builder *config,
                                                  bool enable);
 
+/**
+ * Enable or disable sending TLS 1.3 early data ("0-RTT data") when
+ * resuming a session whose server offered it. Disabled by default.
+ * After the config is built, use rustls_client_connection_write_early_data
+ * to send data in the first flight, and
+ * rustls_client_connection_is_early_data_accepted to learn whether the
+ * server processed it.
+ * https://docs.rs/rustls/0.19.0/rustls/struct.ClientConfig.html#structfield.enable_early_data
+ */
+void rustls_client_config_builder_set_enable_early_data(struct rustls_client_config_builder *config,
+                                                        bool enable);
+
 /**
  * Set the cipher suite list, in preference order. The `ciphersuites`
  * parameter must point to an array containing `len` pointers to
@@ -799,6 +1004,65 @@ enum rustls_result rustls_client_connection_new(const struct rustls_client_confi
                                                 const char *hostname,
                                                 struct rustls_connection **conn_out);
 
+/**
+ * Parse and validate `hostname` as a DNS name, storing the result in the
+ * output parameter `name_out`. `hostname` must be a NUL-terminated string.
+ * Returns RUSTLS_RESULT_INVALID_DNS_NAME_ERROR if the hostname is not
+ * valid UTF-8 or not a syntactically valid DNS name (for instance, an IP
+ * address). On success, the caller owns the rustls_dns_name and must call
+ * rustls_dns_name_free when done with it. A rustls_dns_name may be shared
+ * across any number of rustls_client_connection_new_with_name calls.
+ */
+enum rustls_result rustls_dns_name_new(const char *hostname,
+                                       const struct rustls_dns_name **name_out);
+
+/**
+ * Free a rustls_dns_name previously returned from rustls_dns_name_new.
+ * Calling with NULL is fine. Must not be called twice with the same value.
+ */
+void rustls_dns_name_free(const struct rustls_dns_name *name);
+
+/**
+ * Create a new rustls_connection containing a client connection, like
+ * rustls_client_connection_new, but take the server name as a
+ * prevalidated rustls_dns_name instead of a string. No parsing or
+ * validation happens on this path; all of it was done once in
+ * rustls_dns_name_new. The caller keeps ownership of `name` and may
+ * reuse it for further connections.
+ */
+enum rustls_result rustls_client_connection_new_with_name(const struct rustls_client_config *config,
+                                                          const struct rustls_dns_name *name,
+                                                          struct rustls_connection **conn_out);
+
+/**
+ * Write up to `count` plaintext bytes from `buf` as TLS 1.3 early data
+ * ("0-RTT data"), before the handshake has completed. On success, store
+ * the number of bytes actually written in *out_n. A success with *out_n
+ * set to 0 means early data cannot be sent on this connection: it is not
+ * a client connection, early data was not enabled on the config (see
+ * rustls_client_config_builder_set_enable_early_data), the session being
+ * resumed did not offer early data, the first flight has already gone
+ * out, or the server's early data size limit has been reached. In that
+ * case, send the bytes with rustls_connection_write once the handshake
+ * completes.
+ *
+ * Even after sending, the server may discard the early data. After the
+ * handshake, check rustls_client_connection_is_early_data_accepted: if
+ * it returns false, everything written with this function must be
+ * retransmitted with rustls_connection_write.
+ */
+enum rustls_result rustls_client_connection_write_early_data(struct rustls_connection *conn,
+                                                             const uint8_t *buf,
+                                                             size_t count,
+                                                             size_t *out_n);
+
+/**
+ * Returns true if the server signalled it will process early data sent
+ * with rustls_client_connection_write_early_data. Only meaningful once
+ * the handshake has completed; returns false for server connections.
+ */
+bool rustls_client_connection_is_early_data_accepted(const struct rustls_connection *conn);
+
 /**
  * Register callbacks for persistence of TLS session data. This means either
  * session IDs (TLSv1.2) or . Both
@@ -827,6 +1091,17 @@ void rustls_connection_set_userdata(struct rustls_connection *conn, void *userda
  */
 void rustls_connection_set_log_callback(struct rustls_connection *conn, rustls_log_callback cb);
 
+/**
+ * Set the maximum log level delivered to this connection's log callback.
+ * Levels are the same as in rustls_log_params: 1 = error through
+ * 5 = trace; 0 silences logging for this connection. Records above the
+ * maximum are dropped inside the library with a single integer compare,
+ * before the message is formatted, so filtered levels cost nothing on
+ * the hot path. Connections without an explicit level use the
+ * process-wide default set with rustls_set_default_log_level.
+ */
+void rustls_connection_set_log_level(struct rustls_connection *conn, size_t level);
+
 /**
  * Read some TLS bytes from the network into internal buffers. The actual network
  * I/O is performed by `callback`, which you provide. Rustls will invoke your
@@ -844,6 +1119,45 @@ rustls_io_result rustls_connection_read_tls(struct rustls_connection *conn,
                                             void *userdata,
                                             size_t *out_n);
 
+/**
+ * Read some TLS bytes from the network into internal buffers, like
+ * rustls_connection_read_tls, but invoke `callback` with multiple scattered
+ * buffers (readv-style) so that a full receive queue can be drained with a
+ * single syscall and a single FFI crossing. The TLS bytes delivered by the
+ * callback are staged in a buffer owned by the connection and fed to rustls
+ * from there; any bytes rustls does not accept immediately (because its
+ * internal buffers are full until the next
+ * rustls_connection_process_new_packets) are retained and fed on the next
+ * call. When the staging buffer is full, this sets *out_n to 0 and returns
+ * success; call rustls_connection_process_new_packets to make progress.
+ * The `userdata` parameter is passed through directly to `callback`. Note that
+ * this is distinct from the `userdata` parameter set with
+ * `rustls_connection_set_userdata`.
+ * Returns 0 for success, or an errno value on error. Passes through return values
+ * from callback. See rustls_read_vectored_callback for more details.
+ */
+rustls_io_result rustls_connection_read_tls_vectored(struct rustls_connection *conn,
+                                                     rustls_read_vectored_callback callback,
+                                                     void *userdata,
+                                                     size_t *out_n);
+
+/**
+ * Read up to `count` TLS bytes from `buf` into the connection's internal
+ * buffers, without any callback. This is for applications that perform the
+ * network I/O themselves (for instance with completion-based APIs like
+ * io_uring) and hold received TLS bytes in their own memory: it moves the
+ * bytes directly, with no function-pointer indirection on the hot path.
+ * On success, store the number of bytes consumed in *out_n (this may be
+ * less than `count` if the connection's internal buffers are full; call
+ * rustls_connection_process_new_packets and try again).
+ * Returns 0 for success, or an errno value on error.
+ * https://docs.rs/rustls/0.19.0/rustls/trait.Session.html#tymethod.read_tls
+ */
+rustls_io_result rustls_connection_read_tls_from_buf(struct rustls_connection *conn,
+                                                     const uint8_t *buf,
+                                                     size_t count,
+                                                     size_t *out_n);
+
 /**
  * Write some TLS bytes to the network. The actual network I/O is performed by
  * `callback`, which you provide. Rustls will invoke your callback with a
@@ -878,14 +1192,80 @@ rustls_io_result rustls_connection_write_tls_vectored(struct rustls_connection *
                                                       void *userdata,
                                                       size_t *out_n);
 
+/**
+ * Write up to `count` TLS bytes that the connection has queued for sending
+ * into `buf`, without any callback. This is the counterpart to
+ * rustls_connection_read_tls_from_buf for applications that perform the
+ * network I/O themselves: the TLS bytes are moved directly into
+ * caller-provided memory and can then be sent however the application
+ * chooses (including with completion-based APIs like io_uring).
+ * On success, store the number of bytes written in *out_n (this may be
+ * less than the number of queued bytes; call again with more buffer space
+ * while rustls_connection_wants_write returns true).
+ * Returns 0 for success, or an errno value on error.
+ * https://docs.rs/rustls/0.19.0/rustls/trait.Session.html#tymethod.write_tls
+ */
+rustls_io_result rustls_connection_write_tls_into_buf(struct rustls_connection *conn,
+                                                      uint8_t *buf,
+                                                      size_t count,
+                                                      size_t *out_n);
+
 enum rustls_result rustls_connection_process_new_packets(struct rustls_connection *conn);
 
+/**
+ * Process new packets on each of `count` connections in a single call,
+ * storing the per-connection result in the corresponding element of
+ * `out_results`. This is equivalent to calling
+ * rustls_connection_process_new_packets on each connection in turn, but an
+ * event loop waking up with many readable connections pays the FFI
+ * transition only once for the whole batch. A NULL connection in `conns`
+ * gets RUSTLS_RESULT_NULL_PARAMETER in its result slot and the batch
+ * continues. The function's own return value only reports problems with
+ * the arrays themselves; check the individual results for TLS errors.
+ */
+enum rustls_result rustls_connections_process_batch(struct rustls_connection *const *conns,
+                                                    size_t count,
+                                                    enum rustls_result *out_results);
+
 bool rustls_connection_wants_read(const struct rustls_connection *conn);
 
 bool rustls_connection_wants_write(const struct rustls_connection *conn);
 
+/**
+ * Return the exact number of TLS bytes this connection has queued for
+ * sending. Where rustls_connection_wants_write is a single bit, this lets
+ * an event loop prioritize draining heavily backlogged connections and
+ * apply backpressure proportionally. To get an exact count, the queued
+ * bytes are moved into a buffer owned by the connection; the write_tls
+ * family of functions drains that buffer first, so the byte stream the
+ * application sees is unchanged. Connections that never call this
+ * function do not pay for the extra buffering.
+ */
+size_t rustls_connection_tls_bytes_buffered(struct rustls_connection *conn);
+
 bool rustls_connection_is_handshaking(const struct rustls_connection *conn);
 
+/**
+ * Pre-size the buffers this connection uses, the counterpart to capping
+ * them with rustls_connection_set_buffer_limit. Buffers start empty and
+ * grow on demand, so a connection that is about to move a lot of data
+ * pays a staircase of reallocations as they warm up; a connection that
+ * is known to, say, serve 16 MB responses can instead reserve once up
+ * front. `recv_hint` is applied to the receive-path buffers (staged TLS
+ * input and gathered plaintext), `send_hint` to the staged TLS output
+ * buffer. Hints only ever grow capacity, never shrink it, and either may
+ * be 0 to leave that side alone. Connections recycled through a
+ * rustls_connection_pool keep their capacity, so in a pool the cost is
+ * paid once per slot.
+ *
+ * rustls' own deframer and sendable buffers cannot be pre-sized through
+ * the rustls 0.19 API; the hints cover the buffers this library adds on
+ * the same paths.
+ */
+void rustls_connection_set_initial_buffer_size(struct rustls_connection *conn,
+                                               size_t recv_hint,
+                                               size_t send_hint);
+
 /**
  * Sets a limit on the internal buffers used to buffer unsent plaintext (prior
  * to completing the TLS handshake) and unsent TLS records. By default, there
@@ -939,6 +1319,27 @@ uint16_t rustls_connection_get_protocol_version(const struct rustls_connection *
  */
 const struct rustls_supported_ciphersuite *rustls_connection_get_negotiated_ciphersuite(const struct rustls_connection *conn);
 
+/**
+ * Derive `count` bytes of keying material from the connection's master
+ * secret, as described in RFC 5705, and write them to `buf`. `label` (of
+ * `label_len` bytes) disambiguates between uses; `context` may be NULL for
+ * no context, which is distinct from an empty (zero-length) context.
+ * This fails until the handshake is complete.
+ *
+ * Note that rustls does not expose the negotiated traffic keys, IVs or
+ * record sequence numbers themselves, so a kernel TLS offload handoff is
+ * not possible with this release; exported keying material is the
+ * supported way to bind other protocols to the TLS session.
+ * https://docs.rs/rustls/0.19.0/rustls/trait.Session.html#tymethod.export_keying_material
+ */
+enum rustls_result rustls_connection_export_keying_material(const struct rustls_connection *conn,
+                                                            const uint8_t *label,
+                                                            size_t label_len,
+                                                            const uint8_t *context,
+                                                            size_t context_len,
+                                                            uint8_t *buf,
+                                                            size_t count);
+
 /**
  * Write up to `count` plaintext bytes from `buf` into the `rustls_connection`.
  * This will increase the number of output bytes available to
@@ -951,6 +1352,20 @@ enum rustls_result rustls_connection_write(struct rustls_connection *conn,
                                            size_t count,
                                            size_t *out_n);
 
+/**
+ * Write plaintext bytes from the `count` iovecs in `iov` into the
+ * `rustls_connection`, in order. This is the writev-style counterpart to
+ * rustls_connection_write: rustls packs the fragments into TLS records
+ * directly, so callers with e.g. a header buffer and a body buffer don't
+ * have to coalesce them into one contiguous buffer first.
+ * On success, store the total number of bytes written in *out_n (this may
+ * be less than the sum of the iovec lengths).
+ */
+enum rustls_result rustls_connection_write_vectored(struct rustls_connection *conn,
+                                                    const struct rustls_iovec *iov,
+                                                    size_t count,
+                                                    size_t *out_n);
+
 /**
  * Read up to `count` plaintext bytes from the `rustls_connection` into `buf`.
  * On success, store the number of bytes read in *out_n (this may be less
@@ -969,6 +1384,37 @@ enum rustls_result rustls_connection_read(struct rustls_connection *conn,
                                           size_t count,
                                           size_t *out_n);
 
+/**
+ * Read all plaintext bytes currently available on the `rustls_connection`
+ * and provide access to them without copying them into a caller-provided
+ * buffer. On success, `*out_data` and `*out_n` are set to a borrowed view
+ * of the available bytes. The view is only valid until the next call to
+ * `rustls_connection_read`, `rustls_connection_read_borrowed`,
+ * `rustls_connection_process_new_packets`, or `rustls_connection_free` on
+ * this connection. The caller must copy any bytes it wants to keep longer.
+ * A success with *out_n set to 0 means "all bytes currently available have
+ * been read, but more bytes may become available after subsequent calls to
+ * rustls_connection_read_tls and rustls_connection_process_new_packets."
+ *
+ * Since rustls does not expose its internal plaintext buffers, the bytes
+ * are gathered into a buffer owned by the connection. Compared to
+ * `rustls_connection_read` this saves the copy into (pre-initialized)
+ * caller memory, and allows parsing the plaintext in place.
+ */
+enum rustls_result rustls_connection_read_borrowed(struct rustls_connection *conn,
+                                                   const uint8_t **out_data,
+                                                   size_t *out_n);
+
+/**
+ * Fill `out_stats` with the connection's current statistics. The
+ * underlying counters are bumped on the existing I/O paths as plain
+ * additions, so maintaining them costs close to nothing; this call just
+ * copies them out. May be called at any time, including after the
+ * connection has finished.
+ */
+enum rustls_result rustls_connection_get_stats(const struct rustls_connection *conn,
+                                               struct rustls_connection_stats *out_stats);
+
 /**
  * Free a rustls_connection. Calling with NULL is fine.
  * Must not be called twice with the same value.
@@ -983,6 +1429,16 @@ void rustls_connection_free(struct rustls_connection *conn);
  */
 void rustls_error(enum rustls_result result, char *buf, size_t len, size_t *out_n);
 
+/**
+ * Returns a static string describing the given rustls_result, as a
+ * borrowed rustls_str valid for the life of the process. Unlike
+ * rustls_error this neither formats nor copies anything: every message
+ * exists in the binary already and stringification is a table lookup,
+ * cheap enough for per-connection error logging under a junk-traffic
+ * storm. The messages are the same ones rustls_error produces.
+ */
+struct rustls_str rustls_error_str(enum rustls_result result);
+
 bool rustls_result_is_cert_error(enum rustls_result result);
 
 /**
@@ -990,6 +1446,17 @@ bool rustls_result_is_cert_error(enum rustls_result result);
  */
 struct rustls_str rustls_log_level_str(rustls_log_level level);
 
+/**
+ * Set the default maximum log level for all connections. Levels are the
+ * same as in rustls_log_params: 1 = error through 5 = trace; 0 silences
+ * logging entirely. Records above the maximum are dropped with a single
+ * integer compare, before the message is formatted. The default is
+ * 4 (debug), matching the previous behavior of delivering everything.
+ * Individual connections can override this with
+ * rustls_connection_set_log_level.
+ */
+void rustls_set_default_log_level(rustls_log_level level);
+
 /**
  * Return the length of the outer slice. If the input pointer is NULL,
  * returns 0.
@@ -1127,6 +1594,19 @@ enum rustls_result rustls_server_config_builder_set_certified_keys(struct rustls
                                                                    const struct rustls_certified_key *const *certified_keys,
                                                                    size_t certified_keys_len);
 
+/**
+ * Provide the configuration with swappable certified keys to use for
+ * incoming sessions. This works like
+ * rustls_server_config_builder_set_certified_keys, except the OCSP
+ * response of each key may later be replaced via
+ * rustls_swappable_certified_key_set_ocsp without rebuilding the config.
+ * The config holds references to the swappable keys; the caller usually
+ * keeps its own copies around to perform the swaps.
+ */
+enum rustls_result rustls_server_config_builder_set_swappable_certified_keys(struct rustls_server_config_builder *builder,
+                                                                             const struct rustls_swappable_certified_key *const *certified_keys,
+                                                                             size_t certified_keys_len);
+
 /**
  * Turn a *rustls_server_config_builder (mutable) into a *rustls_server_config
  * (read-only).
@@ -1154,6 +1634,48 @@ void rustls_server_config_free(const struct rustls_server_config *config);
 enum rustls_result rustls_server_connection_new(const struct rustls_server_config *config,
                                                 struct rustls_connection **conn_out);
 
+/**
+ * Create a rustls_connection_pool for server connections using `config`.
+ * The pool retains up to `capacity` returned connections for reuse; beyond
+ * that, returned connections are simply freed. Caller owns the pool and
+ * must call rustls_connection_pool_free when done with it. The pool holds
+ * a reference to the config, so the config may be freed while the pool is
+ * alive. If `config` is NULL, this returns NULL.
+ */
+struct rustls_connection_pool *rustls_connection_pool_new(const struct rustls_server_config *config,
+                                                          size_t capacity);
+
+/**
+ * Take a connection from the pool, storing it in the output parameter
+ * `conn_out`. If the pool has an idle connection it is reset for a new
+ * server session and reused (keeping its internal buffers); otherwise a
+ * new one is allocated, exactly as rustls_server_connection_new would.
+ * The caller owns the resulting connection and should hand it back with
+ * rustls_connection_pool_return when the session is over, or free it with
+ * rustls_connection_free. Any userdata and log callback from the previous
+ * use have been cleared.
+ */
+enum rustls_result rustls_connection_pool_take(const struct rustls_connection_pool *pool,
+                                               struct rustls_connection **conn_out);
+
+/**
+ * Return a connection obtained from rustls_connection_pool_take to the
+ * pool, making its allocations available to a later take. The connection
+ * must not be used (or freed) by the caller after this call. If the pool
+ * already holds `capacity` idle connections, the connection is freed
+ * instead. Calling with a NULL conn is fine.
+ */
+void rustls_connection_pool_return(const struct rustls_connection_pool *pool,
+                                   struct rustls_connection *conn);
+
+/**
+ * Free a rustls_connection_pool and the idle connections it holds.
+ * Connections currently taken from the pool are not affected; free or
+ * return them first. Calling with NULL is fine. Must not be called twice
+ * with the same value.
+ */
+void rustls_connection_pool_free(struct rustls_connection_pool *pool);
+
 /**
  * Copy the SNI hostname to `buf` which can hold up  to `count` bytes,
  * and the length of that hostname in `out_n`. The string is stored in UTF-8
@@ -1168,6 +1690,102 @@ enum rustls_result rustls_server_connection_get_sni_hostname(const struct rustls
                                                              size_t count,
                                                              size_t *out_n);
 
+/**
+ * Extract the SNI hostname from the initial bytes of a TLS stream,
+ * without a rustls_connection. `buf` should hold the bytes received so
+ * far, starting with the first byte of the stream; they are only parsed,
+ * never consumed, so the same bytes can afterwards be fed to a
+ * connection with rustls_connection_read_tls.
+ *
+ * On success, the hostname is copied into `out_buf` (a buffer of size
+ * `count`) and its length is stored in *out_n. A success with *out_n set
+ * to 0 means the ClientHello is complete but carries no SNI extension.
+ * Returns RUSTLS_RESULT_HANDSHAKE_NOT_COMPLETE if `buf` does not yet
+ * contain the whole ClientHello (read more bytes and call again),
+ * RUSTLS_RESULT_INSUFFICIENT_SIZE if the hostname does not fit in
+ * `out_buf`, and RUSTLS_RESULT_CORRUPT_MESSAGE if the bytes are not a
+ * valid TLS ClientHello.
+ *
+ * This enables asynchronous certificate resolution. A
+ * rustls_client_hello_callback must answer synchronously from inside
+ * packet processing, so a certificate that first needs a slow lookup
+ * (disk, sidecar) stalls the thread driving the handshake. Instead, peek
+ * at the SNI here before creating a connection, fetch the certificate
+ * however long that takes while other connections make progress, make it
+ * resolvable (for example by inserting it into the config's
+ * rustls_certified_key_map), and only then create the connection and
+ * replay the buffered bytes into it.
+ */
+enum rustls_result rustls_sni_from_client_hello(const uint8_t *buf,
+                                                size_t len,
+                                                uint8_t *out_buf,
+                                                size_t count,
+                                                size_t *out_n);
+
+/**
+ * Return the SNI hostname as a borrowed rustls_str, without copying. The
+ * returned str is valid until the connection is freed; treating it as
+ * `'static` beyond that point is undefined behavior. Unlike
+ * rustls_server_connection_get_sni_hostname this needs no caller buffer,
+ * cannot fail for lack of space, and so never needs a retry. Returns a
+ * zero-length rustls_str if no SNI hostname is available on this
+ * connection, because it hasn't been processed yet, because the client
+ * did not send SNI, or because this is not a server connection.
+ * https://docs.rs/rustls/0.19.0/rustls/struct.ServerSession.html#method.get_sni_hostname
+ */
+struct rustls_str rustls_server_connection_get_sni_hostname_str(const struct rustls_connection *conn);
+
+/**
+ * Create a new, empty rustls_certified_key_map. Caller owns the memory
+ * and must either hand the map to rustls_server_config_builder_set_key_map
+ * (which takes ownership) or free it with rustls_certified_key_map_free.
+ */
+struct rustls_certified_key_map *rustls_certified_key_map_new(void);
+
+/**
+ * Add a certified key to the map, to be used for connections whose SNI
+ * hostname equals `dns_name` (a NUL-terminated string). `dns_name` may
+ * start with "*." to match any single leading label, e.g. "*.example.com"
+ * matches "www.example.com" but neither "example.com" nor
+ * "a.b.example.com". Inserting a name that is already present replaces
+ * the earlier entry. For non-wildcard names, this checks that the key's
+ * end-entity certificate is valid for the name, and returns an error
+ * describing the problem if not. The map holds a reference to the key;
+ * the caller may free its own copy at any time.
+ */
+enum rustls_result rustls_certified_key_map_insert(struct rustls_certified_key_map *map,
+                                                   const char *dns_name,
+                                                   const struct rustls_certified_key *key);
+
+/**
+ * Like rustls_certified_key_map_insert, but with a swappable certified
+ * key: the OCSP response published via
+ * rustls_swappable_certified_key_set_ocsp is picked up by handshakes
+ * resolving through this map, with no config rebuild. The map holds a
+ * reference to the swappable key; the caller may free its own copy at any
+ * time, but usually keeps it around to perform the swaps.
+ */
+enum rustls_result rustls_certified_key_map_insert_swappable(struct rustls_certified_key_map *map,
+                                                             const char *dns_name,
+                                                             const struct rustls_swappable_certified_key *key);
+
+/**
+ * Use `map` to choose the server certificate based on the client's SNI
+ * hostname. This takes ownership of the map: the caller must not use or
+ * free it afterwards. Connections without SNI, or whose hostname matches
+ * no entry, fail their handshake. This replaces any certified keys set
+ * with rustls_server_config_builder_set_certified_keys (and vice versa).
+ */
+enum rustls_result rustls_server_config_builder_set_key_map(struct rustls_server_config_builder *builder,
+                                                            struct rustls_certified_key_map *map);
+
+/**
+ * Free a rustls_certified_key_map that was not handed to
+ * rustls_server_config_builder_set_key_map. Calling with NULL is fine.
+ * Must not be called twice with the same value.
+ */
+void rustls_certified_key_map_free(struct rustls_certified_key_map *map);
+
 /**
  * Register a callback to be invoked when a session created from this config
  * is seeing a TLS ClientHello message. If `userdata` has been set with
@@ -1221,4 +1839,45 @@ enum rustls_result rustls_server_config_builder_set_persistence(struct rustls_se
                                                                 rustls_session_store_get_callback get_cb,
                                                                 rustls_session_store_put_callback put_cb);
 
+/**
+ * Enable fully stateless session resumption using session tickets sealed
+ * with the given keys. `keys` must point to a buffer of `keys_len`
+ * `rustls_slice_bytes`, each holding one 32-byte ChaCha20-Poly1305 key.
+ * New tickets are sealed under the first key; tickets sealed under any of
+ * the other keys are still accepted, so keys can be rotated by prepending
+ * a fresh key and keeping the old ones around for as long as outstanding
+ * tickets should stay valid. Give all servers behind a load balancer the
+ * same keys and any of them can resume a session started on another, with
+ * no shared session store. `lifetime_seconds` is the ticket lifetime
+ * advertised to clients.
+ *
+ * The keys are highly sensitive data: anyone holding them can decrypt
+ * sessions resumed with a ticket. This function copies the key material;
+ * the caller should zeroize its own copy when appropriate.
+ *
+ * With a ticketer installed, the session store (whether registered via
+ * rustls_server_config_builder_set_persistence or
+ * rustls_server_config_builder_set_memory_cache) is no longer consulted
+ * for ticket-based resumption.
+ */
+enum rustls_result rustls_server_config_builder_set_ticket_keys(struct rustls_server_config_builder *builder,
+                                                                const struct rustls_slice_bytes *keys,
+                                                                size_t keys_len,
+                                                                uint32_t lifetime_seconds);
+
+/**
+ * Register a built-in, in-memory store for TLS session IDs and secrets,
+ * holding up to `capacity` entries. Entries beyond the capacity evict the
+ * least recently used ones. The store is sharded over several independent
+ * locks internally, so resumption lookups from concurrent handshakes
+ * scale across cores without a global mutex, and no FFI callback is
+ * involved. `capacity` must be larger than 0.
+ *
+ * This replaces any store previously registered on the builder, including
+ * callbacks registered via rustls_server_config_builder_set_persistence
+ * (and vice versa).
+ */
+enum rustls_result rustls_server_config_builder_set_memory_cache(struct rustls_server_config_builder *builder,
+                                                                 size_t capacity);
+
 #endif /* CRUSTLS_H */
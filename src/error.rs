@@ -1,6 +1,7 @@
 use std::{cmp::min, fmt::Display, slice};
 
 use crate::ffi_panic_boundary;
+use crate::rslice::rustls_str;
 use libc::{c_char, size_t};
 use rustls::TLSError;
 
@@ -41,6 +42,106 @@ pub extern "C" fn rustls_error(
     }
 }
 
+/// Returns a static string describing the given rustls_result, as a
+/// borrowed rustls_str valid for the life of the process. Unlike
+/// rustls_error this neither formats nor copies anything: every message
+/// exists in the binary already and stringification is a table lookup,
+/// cheap enough for per-connection error logging under a junk-traffic
+/// storm. The messages are the same ones rustls_error produces.
+#[no_mangle]
+pub extern "C" fn rustls_error_str(result: rustls_result) -> rustls_str<'static> {
+    use rustls_result::*;
+    let msg: &'static str = match result {
+        Ok => "OK",
+        Io => "I/O error",
+        NullParameter => "a parameter was NULL",
+        InvalidDnsNameError => "hostname was either malformed or an IP address (rustls does not support certificates for IP addresses)",
+        Panic => "a Rust component panicked",
+        CertificateParseError => "error parsing certificate",
+        PrivateKeyParseError => "error parsing private key",
+        InsufficientSize => "provided buffer is of insufficient size",
+        NotFound => "the item was not found",
+        InvalidParameter => "a parameter had an invalid value",
+
+        InappropriateMessage => "received unexpected message",
+        InappropriateHandshakeMessage => "received unexpected handshake message",
+        CorruptMessagePayload => "received corrupt message",
+
+        CorruptMessage => "received corrupt message",
+        NoCertificatesPresented => "peer sent no certificates",
+        DecryptError => "cannot decrypt peer's message",
+        FailedToGetCurrentTime => "failed to get current time",
+        HandshakeNotComplete => "handshake not complete",
+        PeerSentOversizedRecord => "peer sent excess record size",
+        NoApplicationProtocol => "peer doesn't support any known protocol",
+        PeerIncompatibleError => "peer is incompatible: reason omitted",
+        PeerMisbehavedError => "peer misbehaved: reason omitted",
+        General => "unexpected error: omitted",
+        AlertCloseNotify => "received fatal alert: CloseNotify",
+        AlertUnexpectedMessage => "received fatal alert: UnexpectedMessage",
+        AlertBadRecordMac => "received fatal alert: BadRecordMac",
+        AlertDecryptionFailed => "received fatal alert: DecryptionFailed",
+        AlertRecordOverflow => "received fatal alert: RecordOverflow",
+        AlertDecompressionFailure => "received fatal alert: DecompressionFailure",
+        AlertHandshakeFailure => "received fatal alert: HandshakeFailure",
+        AlertNoCertificate => "received fatal alert: NoCertificate",
+        AlertBadCertificate => "received fatal alert: BadCertificate",
+        AlertUnsupportedCertificate => "received fatal alert: UnsupportedCertificate",
+        AlertCertificateRevoked => "received fatal alert: CertificateRevoked",
+        AlertCertificateExpired => "received fatal alert: CertificateExpired",
+        AlertCertificateUnknown => "received fatal alert: CertificateUnknown",
+        AlertIllegalParameter => "received fatal alert: IllegalParameter",
+        AlertUnknownCA => "received fatal alert: UnknownCA",
+        AlertAccessDenied => "received fatal alert: AccessDenied",
+        AlertDecodeError => "received fatal alert: DecodeError",
+        AlertDecryptError => "received fatal alert: DecryptError",
+        AlertExportRestriction => "received fatal alert: ExportRestriction",
+        AlertProtocolVersion => "received fatal alert: ProtocolVersion",
+        AlertInsufficientSecurity => "received fatal alert: InsufficientSecurity",
+        AlertInternalError => "received fatal alert: InternalError",
+        AlertInappropriateFallback => "received fatal alert: InappropriateFallback",
+        AlertUserCanceled => "received fatal alert: UserCanceled",
+        AlertNoRenegotiation => "received fatal alert: NoRenegotiation",
+        AlertMissingExtension => "received fatal alert: MissingExtension",
+        AlertUnsupportedExtension => "received fatal alert: UnsupportedExtension",
+        AlertCertificateUnobtainable => "received fatal alert: CertificateUnobtainable",
+        AlertUnrecognisedName => "received fatal alert: UnrecognisedName",
+        AlertBadCertificateStatusResponse => "received fatal alert: BadCertificateStatusResponse",
+        AlertBadCertificateHashValue => "received fatal alert: BadCertificateHashValue",
+        AlertUnknownPSKIdentity => "received fatal alert: UnknownPSKIdentity",
+        AlertCertificateRequired => "received fatal alert: CertificateRequired",
+        AlertNoApplicationProtocol => "received fatal alert: NoApplicationProtocol",
+        AlertUnknown => "received fatal alert: Unknown(0)",
+
+        CertBadDER => "invalid certificate: BadDER",
+        CertBadDERTime => "invalid certificate: BadDERTime",
+        CertCAUsedAsEndEntity => "invalid certificate: CAUsedAsEndEntity",
+        CertExpired => "invalid certificate: CertExpired",
+        CertNotValidForName => "invalid certificate: CertNotValidForName",
+        CertNotValidYet => "invalid certificate: CertNotValidYet",
+        CertEndEntityUsedAsCA => "invalid certificate: EndEntityUsedAsCA",
+        CertExtensionValueInvalid => "invalid certificate: ExtensionValueInvalid",
+        CertInvalidCertValidity => "invalid certificate: InvalidCertValidity",
+        CertInvalidSignatureForPublicKey => "invalid certificate: InvalidSignatureForPublicKey",
+        CertNameConstraintViolation => "invalid certificate: NameConstraintViolation",
+        CertPathLenConstraintViolated => "invalid certificate: PathLenConstraintViolated",
+        CertSignatureAlgorithmMismatch => "invalid certificate: SignatureAlgorithmMismatch",
+        CertRequiredEKUNotFound => "invalid certificate: RequiredEKUNotFound",
+        CertUnknownIssuer => "invalid certificate: UnknownIssuer",
+        CertUnsupportedCertVersion => "invalid certificate: UnsupportedCertVersion",
+        CertUnsupportedCriticalExtension => "invalid certificate: UnsupportedCriticalExtension",
+        CertUnsupportedSignatureAlgorithmForPublicKey => "invalid certificate: UnsupportedSignatureAlgorithmForPublicKey",
+        CertUnsupportedSignatureAlgorithm => "invalid certificate: UnsupportedSignatureAlgorithm",
+
+        CertSCTMalformed => "invalid certificate timestamp: MalformedSCT",
+        CertSCTInvalidSignature => "invalid certificate timestamp: InvalidSignature",
+        CertSCTTimestampInFuture => "invalid certificate timestamp: TimestampInFuture",
+        CertSCTUnsupportedVersion => "invalid certificate timestamp: UnsupportedSCTVersion",
+        CertSCTUnknownLog => "invalid certificate timestamp: UnknownLog",
+    };
+    rustls_str::from_str_unchecked(msg)
+}
+
 #[no_mangle]
 pub extern "C" fn rustls_result_is_cert_error(result: rustls_result) -> bool {
     match result_to_tlserror(&result) {
@@ -396,3 +497,29 @@ pub(crate) fn result_to_tlserror(input: &rustls_result) -> Either {
     };
     Either::TLSError(e)
 }
+
+#[test]
+fn test_error_str_matches_rustls_error() {
+    use rustls_result::*;
+    // One representative of each message family; the families share their
+    // construction, so agreement here means agreement everywhere.
+    for result in [
+        Ok,
+        InvalidDnsNameError,
+        CorruptMessagePayload,
+        PeerSentOversizedRecord,
+        PeerMisbehavedError,
+        General,
+        AlertCloseNotify,
+        AlertUnknownCA,
+        AlertUnknown,
+        CertBadDER,
+        CertUnsupportedSignatureAlgorithmForPublicKey,
+        CertSCTUnknownLog,
+    ] {
+        let want = result.to_string();
+        let got = rustls_error_str(result);
+        let got = unsafe { slice::from_raw_parts(got.data as *const u8, got.len) };
+        assert_eq!(std::str::from_utf8(got).unwrap(), want);
+    }
+}
@@ -1,4 +1,4 @@
-use std::io::{Error, IoSlice, Read, Result, Write};
+use std::io::{Error, IoSlice, IoSliceMut, Read, Result, Write};
 
 use libc::{c_void, size_t};
 
@@ -108,6 +108,67 @@ pub struct rustls_iovec {
     _private: [u8; 0],
 }
 
+/// A callback for rustls_connection_read_tls_vectored.
+/// An implementation of this callback should attempt to read from the
+/// network into the given `count` iovecs, in order. If any bytes were read,
+/// the implementation should set out_n to the total number of bytes read and
+/// return 0. If there was an error, the implementation should return a
+/// nonzero rustls_io_result, which will be passed through to the caller.
+/// On POSIX systems, returning `errno` is convenient. On other systems, any
+/// appropriate error code works.
+/// It's best to make one read attempt to the network per call. Additional
+/// reads will be triggered by subsequent calls to one of the `_read_tls`
+/// methods.
+/// `userdata` is set to the value provided to `rustls_connection_set_userdata`.
+/// In most cases that should be a struct that contains, at a minimum, a file
+/// descriptor.
+/// The iov and out_n pointers are borrowed and should not be retained across calls.
+pub type rustls_read_vectored_callback = Option<
+    unsafe extern "C" fn(
+        userdata: *mut c_void,
+        iov: *mut rustls_iovec,
+        count: size_t,
+        out_n: *mut size_t,
+    ) -> rustls_io_result,
+>;
+
+pub(crate) type VectoredReadCallback = unsafe extern "C" fn(
+    userdata: *mut c_void,
+    iov: *mut rustls_iovec,
+    count: size_t,
+    out_n: *mut size_t,
+) -> rustls_io_result;
+
+pub(crate) struct VectoredCallbackReader {
+    pub callback: VectoredReadCallback,
+    pub userdata: *mut c_void,
+}
+
+impl Read for VectoredCallbackReader {
+    fn read(&mut self, buf: &mut [u8]) -> Result<usize> {
+        self.read_vectored(&mut [IoSliceMut::new(buf)])
+    }
+
+    fn read_vectored(&mut self, bufs: &mut [IoSliceMut<'_>]) -> Result<usize> {
+        let mut out_n: usize = 0;
+        let cb = self.callback;
+        let result = unsafe {
+            cb(
+                self.userdata,
+                // This cast is sound because IoSliceMut is documented to be
+                // ABI-compatible with iovec on Unix, and with WSABUF on Windows.
+                bufs.as_mut_ptr() as *mut rustls_iovec,
+                bufs.len(),
+                &mut out_n,
+            )
+        };
+        match result.0 {
+            0 => Ok(out_n),
+            e => Err(Error::from_raw_os_error(e)),
+        }
+    }
+}
+
 /// A callback for rustls_connection_write_tls_vectored.
 /// An implementation of this callback should attempt to write the bytes in
 /// the given `count` iovecs to the network. If any bytes were written,
@@ -40,6 +40,7 @@ thread_local! {
 pub struct Userdata {
     userdata: *mut c_void,
     log_callback: rustls_log_callback,
+    log_level: usize,
 }
 
 /// UserdataGuard pops an entry off the USERDATA stack, restoring the
@@ -62,6 +63,7 @@ impl UserdataGuard {
             data: Some(Userdata {
                 userdata: u,
                 log_callback: None,
+                log_level: 0,
             }),
         }
     }
@@ -124,6 +126,7 @@ pub enum UserdataError {
 pub fn userdata_push(
     u: *mut c_void,
     cb: rustls_log_callback,
+    log_level: usize,
 ) -> Result<UserdataGuard, UserdataError> {
     USERDATA
         .try_with(|userdata| {
@@ -133,6 +136,7 @@ pub fn userdata_push(
                     v.push(Userdata {
                         userdata: u,
                         log_callback: cb,
+                        log_level,
                     });
                     Ok(())
                 },
@@ -156,13 +160,13 @@ pub fn userdata_get() -> Result<*mut c_void, UserdataError> {
         .unwrap_or(Err(UserdataError::AccessError))
 }
 
-pub fn log_callback_get() -> Result<(rustls_log_callback, *mut c_void), UserdataError> {
+pub fn log_callback_get() -> Result<(rustls_log_callback, *mut c_void, usize), UserdataError> {
     USERDATA
         .try_with(|userdata| {
             userdata.try_borrow_mut().map_or_else(
                 |_| Err(UserdataError::AlreadyBorrowed),
                 |v| match v.last() {
-                    Some(u) => Ok((u.log_callback, u.userdata)),
+                    Some(u) => Ok((u.log_callback, u.userdata, u.log_level)),
                     None => Err(UserdataError::EmptyStack),
                 },
             )
@@ -179,7 +183,7 @@ mod tests {
     fn guard_try_pop() {
         let data = "hello";
         let data_ptr: *mut c_void = data as *const _ as _;
-        let mut guard = userdata_push(data_ptr, None).unwrap();
+        let mut guard = userdata_push(data_ptr, None, 0).unwrap();
         assert_eq!(userdata_get().unwrap(), data_ptr);
         guard.try_pop().unwrap();
         assert!(matches!(guard.try_pop(), Err(_)));
@@ -189,7 +193,7 @@ mod tests {
     fn guard_try_drop() {
         let data = "hello";
         let data_ptr: *mut c_void = data as *const _ as _;
-        let guard = userdata_push(data_ptr, None).unwrap();
+        let guard = userdata_push(data_ptr, None, 0).unwrap();
         assert_eq!(userdata_get().unwrap(), data_ptr);
         guard.try_drop().unwrap();
         assert!(matches!(userdata_get(), Err(_)));
@@ -200,7 +204,7 @@ mod tests {
         let data = "hello";
         let data_ptr: *mut c_void = data as *const _ as _;
         {
-            let _guard = userdata_push(data_ptr, None).unwrap();
+            let _guard = userdata_push(data_ptr, None, 0).unwrap();
             assert_eq!(userdata_get().unwrap(), data_ptr);
         }
         assert!(matches!(userdata_get(), Err(_)));
@@ -211,12 +215,12 @@ mod tests {
         let hello = "hello";
         let hello_ptr: *mut c_void = hello as *const _ as _;
         {
-            let guard = userdata_push(hello_ptr, None).unwrap();
+            let guard = userdata_push(hello_ptr, None, 0).unwrap();
             assert_eq!(userdata_get().unwrap(), hello_ptr);
             {
                 let yo = "yo";
                 let yo_ptr: *mut c_void = yo as *const _ as _;
-                let guard2 = userdata_push(yo_ptr, None).unwrap();
+                let guard2 = userdata_push(yo_ptr, None, 0).unwrap();
                 assert_eq!(userdata_get().unwrap(), yo_ptr);
                 guard2.try_drop().unwrap();
             }
@@ -230,12 +234,12 @@ mod tests {
     fn out_of_order_drop() {
         let hello = "hello";
         let hello_ptr: *mut c_void = hello as *const _ as _;
-        let guard = userdata_push(hello_ptr, None).unwrap();
+        let guard = userdata_push(hello_ptr, None, 0).unwrap();
         assert_eq!(userdata_get().unwrap(), hello_ptr);
 
         let yo = "yo";
         let yo_ptr: *mut c_void = yo as *const _ as _;
-        let guard2 = userdata_push(yo_ptr, None).unwrap();
+        let guard2 = userdata_push(yo_ptr, None, 0).unwrap();
         assert_eq!(userdata_get().unwrap(), yo_ptr);
 
         assert!(matches!(guard.try_drop(), Err(UserdataError::WrongData)));
@@ -246,19 +250,19 @@ mod tests {
     fn userdata_multi_threads() {
         let hello = "hello";
         let hello_ptr: *mut c_void = hello as *const _ as _;
-        let guard = userdata_push(hello_ptr, None).unwrap();
+        let guard = userdata_push(hello_ptr, None, 0).unwrap();
         assert_eq!(userdata_get().unwrap(), hello_ptr);
 
         let thread1 = thread::spawn(|| {
             let yo = "yo";
             let yo_ptr: *mut c_void = yo as *const _ as _;
-            let guard2 = userdata_push(yo_ptr, None).unwrap();
+            let guard2 = userdata_push(yo_ptr, None, 0).unwrap();
             assert_eq!(userdata_get().unwrap(), yo_ptr);
 
             let greetz = "greetz";
             let greetz_ptr: *mut c_void = greetz as *const _ as _;
 
-            let guard3 = userdata_push(greetz_ptr, None).unwrap();
+            let guard3 = userdata_push(greetz_ptr, None, 0).unwrap();
 
             assert_eq!(userdata_get().unwrap(), greetz_ptr);
             guard3.try_drop().unwrap();
@@ -1,10 +1,19 @@
 use std::convert::TryInto;
+use std::sync::atomic::{AtomicUsize, Ordering};
 
 use libc::c_void;
 use log::Level;
 
 use crate::{log_callback_get, rslice::rustls_str};
 
+/// The log level used for connections that have not had one set with
+/// rustls_connection_set_log_level.
+static DEFAULT_LOG_LEVEL: AtomicUsize = AtomicUsize::new(Level::Debug as usize);
+
+pub(crate) fn default_log_level() -> usize {
+    DEFAULT_LOG_LEVEL.load(Ordering::Relaxed)
+}
+
 struct Logger {}
 
 impl log::Log for Logger {
@@ -12,7 +21,12 @@ impl log::Log for Logger {
         true
     }
     fn log(&self, record: &log::Record<'_>) {
-        if let Ok((Some(cb), userdata)) = log_callback_get() {
+        if let Ok((Some(cb), userdata, max_level)) = log_callback_get() {
+            // Filter before formatting: records above the connection's
+            // level cost one integer compare, not a string format.
+            if record.level() as usize > max_level {
+                return;
+            }
             let message = format!("{} {}", record.target(), record.args());
             if let Ok(message) = message.as_str().try_into() {
                 unsafe {
@@ -51,6 +65,18 @@ pub extern "C" fn rustls_log_level_str(level: rustls_log_level) -> rustls_str<'s
     rustls_str::from_str_unchecked(s)
 }
 
+/// Set the default maximum log level for all connections. Levels are the
+/// same as in rustls_log_params: 1 = error through 5 = trace; 0 silences
+/// logging entirely. Records above the maximum are dropped with a single
+/// integer compare, before the message is formatted. The default is
+/// 4 (debug), matching the previous behavior of delivering everything.
+/// Individual connections can override this with
+/// rustls_connection_set_log_level.
+#[no_mangle]
+pub extern "C" fn rustls_set_default_log_level(level: rustls_log_level) {
+    DEFAULT_LOG_LEVEL.store(level, Ordering::Relaxed);
+}
+
 #[repr(C)]
 pub struct rustls_log_params<'a> {
     level: rustls_log_level,
@@ -1,6 +1,7 @@
 use libc::EINVAL;
 
 use crate::error::{rustls_io_result, rustls_result};
+use crate::rslice::rustls_str;
 
 use std::ptr::{null, null_mut};
 
@@ -31,6 +32,7 @@ impl Defaultable for usize {}
 impl Defaultable for bool {}
 impl Defaultable for () {}
 impl<T> Defaultable for Option<T> {}
+impl Defaultable for rustls_str<'_> {}
 
 impl<T: Defaultable> PanicOrDefault for T {
     fn value() -> Self {
@@ -103,3 +105,29 @@ macro_rules! ffi_panic_boundary {
         }
     }
 }
+
+// Per-record entry points like rustls_connection_read and
+// rustls_connection_process_new_packets use ffi_hot_path_boundary!
+// instead. By default it is identical to ffi_panic_boundary!, but the
+// `unchecked-ffi` cargo feature compiles it down to a plain block,
+// removing the catch_unwind machinery from functions that get called
+// once per record. With that feature, a panic in a hot-path function
+// would unwind across the FFI boundary, which is undefined behavior, so
+// such builds must abort on panic instead: `make UNCHECKED_FFI=1` passes
+// both the feature and `-C panic=abort`. Setup and teardown functions
+// keep the boundary unconditionally; they are not worth the trade.
+#[cfg(not(feature = "unchecked-ffi"))]
+#[macro_export]
+macro_rules! ffi_hot_path_boundary {
+    ( $($tt:tt)* ) => {
+        $crate::ffi_panic_boundary! { $($tt)* }
+    }
+}
+
+#[cfg(feature = "unchecked-ffi")]
+#[macro_export]
+macro_rules! ffi_hot_path_boundary {
+    ( $($tt:tt)* ) => {{
+        $($tt)*
+    }}
+}
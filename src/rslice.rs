@@ -171,6 +171,25 @@ impl<'a> rustls_str<'a> {
             phantom: PhantomData,
         }
     }
+
+    /// Erase the borrow checker's knowledge of this str's lifetime.
+    /// This is unsafe because the caller takes over responsibility for the
+    /// lifetime: the returned rustls_str must not outlive the memory it
+    /// points into, which must be documented on the function that hands it
+    /// across the FFI boundary.
+    pub(crate) unsafe fn into_static(self) -> rustls_str<'static> {
+        rustls_str {
+            data: self.data,
+            len: self.len,
+            phantom: PhantomData,
+        }
+    }
+}
+
+impl Default for rustls_str<'_> {
+    fn default() -> Self {
+        Self::from_str_unchecked("")
+    }
 }
 
 #[test]
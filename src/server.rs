@@ -1,30 +1,38 @@
-use std::convert::TryInto;
-use std::ffi::c_void;
+use std::collections::HashMap;
+use std::convert::{TryFrom, TryInto};
+use std::ffi::{c_void, CStr};
 use std::ptr::null_mut;
 use std::slice;
-use std::sync::Arc;
+use std::sync::{Arc, Mutex};
 
-use libc::size_t;
+use libc::{c_char, size_t};
+use rustls::internal::msgs::codec::Reader;
+use rustls::internal::msgs::enums::{ContentType, HandshakeType};
+use rustls::internal::msgs::handshake::{
+    ConvertServerNameList, HandshakeMessagePayload, HandshakePayload,
+};
+use rustls::internal::msgs::message::{Message, MessageError, MessagePayload};
 use rustls::sign::CertifiedKey;
 use rustls::{
     AllowAnyAnonymousOrAuthenticatedClient, AllowAnyAuthenticatedClient, ClientHello, NoClientAuth,
-    ServerConfig, ServerSession,
+    ProtocolVersion, ServerConfig, ServerSession,
 };
 use rustls::{ResolvesServerCert, ALL_CIPHERSUITES};
 use rustls::{SignatureScheme, SupportedCipherSuite};
 
 use crate::cipher::{
     rustls_certified_key, rustls_client_cert_verifier, rustls_client_cert_verifier_optional,
-    rustls_supported_ciphersuite,
+    rustls_supported_ciphersuite, rustls_swappable_certified_key, SwappableCertifiedKey,
 };
 use crate::connection::{rustls_connection, Connection};
 use crate::enums::rustls_tls_version_from_u16;
-use crate::error::rustls_result;
 use crate::error::rustls_result::{InvalidParameter, NullParameter};
+use crate::error::{map_error, rustls_result};
 use crate::rslice::{rustls_slice_bytes, rustls_slice_slice_bytes, rustls_slice_u16, rustls_str};
 use crate::session::{
-    rustls_session_store_get_callback, rustls_session_store_put_callback, SessionStoreBroker,
-    SessionStoreGetCallback, SessionStorePutCallback,
+    rustls_session_store_get_callback, rustls_session_store_put_callback, CallerProvidedTicketer,
+    SessionStoreBroker, SessionStoreGetCallback, SessionStorePutCallback, ShardedMemoryCache,
+    TICKET_KEY_LEN,
 };
 use crate::{
     arc_with_incref_from_raw, ffi_panic_boundary, try_mut_from_ptr, try_mut_slice,
@@ -286,6 +294,38 @@ pub extern "C" fn rustls_server_config_builder_set_certified_keys(
     }
 }
 
+/// Provide the configuration with swappable certified keys to use for
+/// incoming sessions. This works like
+/// rustls_server_config_builder_set_certified_keys, except the OCSP
+/// response of each key may later be replaced via
+/// rustls_swappable_certified_key_set_ocsp without rebuilding the config.
+/// The config holds references to the swappable keys; the caller usually
+/// keeps its own copies around to perform the swaps.
+#[no_mangle]
+pub extern "C" fn rustls_server_config_builder_set_swappable_certified_keys(
+    builder: *mut rustls_server_config_builder,
+    certified_keys: *const *const rustls_swappable_certified_key,
+    certified_keys_len: size_t,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let config: &mut ServerConfig = try_mut_from_ptr!(builder);
+        let keys_ptrs: &[*const rustls_swappable_certified_key] =
+            try_slice!(certified_keys, certified_keys_len);
+        let mut keys: Vec<Arc<SwappableCertifiedKey>> = Vec::new();
+        for &key_ptr in keys_ptrs {
+            let certified_key: Arc<SwappableCertifiedKey> = unsafe {
+                match (key_ptr as *const SwappableCertifiedKey).as_ref() {
+                    Some(c) => arc_with_incref_from_raw(c),
+                    None => return NullParameter,
+                }
+            };
+            keys.push(certified_key);
+        }
+        config.cert_resolver = Arc::new(ResolvesServerCertFromSwappableChoices { choices: keys });
+        rustls_result::Ok
+    }
+}
+
 /// Turn a *rustls_server_config_builder (mutable) into a *rustls_server_config
 /// (read-only).
 #[no_mangle]
@@ -347,6 +387,122 @@ pub extern "C" fn rustls_server_connection_new(
     }
 }
 
+/// A pool of server connections sharing one rustls_server_config. Taking a
+/// connection from the pool reuses the heap allocations of a previously
+/// returned one, so a server accepting many short-lived connections does
+/// not pay for a fresh allocation on every accept. The pool is safe to
+/// share between threads. Under the hood, this object corresponds to a
+/// Box<ConnectionPool>.
+pub struct rustls_connection_pool {
+    // We use the opaque struct pattern to tell C about our types without
+    // telling them what's inside.
+    // https://doc.rust-lang.org/nomicon/ffi.html#representing-opaque-structs
+    _private: [u8; 0],
+}
+
+pub(crate) struct ConnectionPool {
+    config: Arc<ServerConfig>,
+    capacity: usize,
+    free: Mutex<Vec<Box<Connection>>>,
+}
+
+impl CastPtr for rustls_connection_pool {
+    type RustType = ConnectionPool;
+}
+
+/// Create a rustls_connection_pool for server connections using `config`.
+/// The pool retains up to `capacity` returned connections for reuse; beyond
+/// that, returned connections are simply freed. Caller owns the pool and
+/// must call rustls_connection_pool_free when done with it. The pool holds
+/// a reference to the config, so the config may be freed while the pool is
+/// alive. If `config` is NULL, this returns NULL.
+#[no_mangle]
+pub extern "C" fn rustls_connection_pool_new(
+    config: *const rustls_server_config,
+    capacity: size_t,
+) -> *mut rustls_connection_pool {
+    ffi_panic_boundary! {
+        let config: Arc<ServerConfig> = unsafe {
+            match (config as *const ServerConfig).as_ref() {
+                Some(c) => arc_with_incref_from_raw(c),
+                None => return null_mut(),
+            }
+        };
+        let pool = ConnectionPool {
+            config,
+            capacity,
+            free: Mutex::new(Vec::with_capacity(capacity)),
+        };
+        Box::into_raw(Box::new(pool)) as *mut _
+    }
+}
+
+/// Take a connection from the pool, storing it in the output parameter
+/// `conn_out`. If the pool has an idle connection it is reset for a new
+/// server session and reused (keeping its internal buffers); otherwise a
+/// new one is allocated, exactly as rustls_server_connection_new would.
+/// The caller owns the resulting connection and should hand it back with
+/// rustls_connection_pool_return when the session is over, or free it with
+/// rustls_connection_free. Any userdata and log callback from the previous
+/// use have been cleared.
+#[no_mangle]
+pub extern "C" fn rustls_connection_pool_take(
+    pool: *const rustls_connection_pool,
+    conn_out: *mut *mut rustls_connection,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let pool: &ConnectionPool = try_ref_from_ptr!(pool);
+        let session = ServerSession::new(&pool.config);
+        let recycled = pool.free.lock().ok().and_then(|mut free| free.pop());
+        let c: Box<Connection> = match recycled {
+            Some(mut c) => {
+                c.reset_server(session);
+                c
+            }
+            None => Box::new(Connection::from_server(session)),
+        };
+        unsafe {
+            *conn_out = Box::into_raw(c) as *mut _;
+        }
+        rustls_result::Ok
+    }
+}
+
+/// Return a connection obtained from rustls_connection_pool_take to the
+/// pool, making its allocations available to a later take. The connection
+/// must not be used (or freed) by the caller after this call. If the pool
+/// already holds `capacity` idle connections, the connection is freed
+/// instead. Calling with a NULL conn is fine.
+#[no_mangle]
+pub extern "C" fn rustls_connection_pool_return(
+    pool: *const rustls_connection_pool,
+    conn: *mut rustls_connection,
+) {
+    ffi_panic_boundary! {
+        let pool: &ConnectionPool = try_ref_from_ptr!(pool);
+        let conn: &mut Connection = try_mut_from_ptr!(conn);
+        let conn: Box<Connection> = unsafe { Box::from_raw(conn) };
+        if let Ok(mut free) = pool.free.lock() {
+            if free.len() < pool.capacity {
+                free.push(conn);
+            }
+        }
+    }
+}
+
+/// Free a rustls_connection_pool and the idle connections it holds.
+/// Connections currently taken from the pool are not affected; free or
+/// return them first. Calling with NULL is fine. Must not be called twice
+/// with the same value.
+#[no_mangle]
+pub extern "C" fn rustls_connection_pool_free(pool: *mut rustls_connection_pool) {
+    ffi_panic_boundary! {
+        let pool: &mut ConnectionPool = try_mut_from_ptr!(pool);
+        // Convert the pointer to a Box and drop it.
+        unsafe { Box::from_raw(pool); }
+    }
+}
+
 /// Copy the SNI hostname to `buf` which can hold up  to `count` bytes,
 /// and the length of that hostname in `out_n`. The string is stored in UTF-8
 /// with no terminating NUL byte.
@@ -385,6 +541,135 @@ pub extern "C" fn rustls_server_connection_get_sni_hostname(
     }
 }
 
+/// Extract the SNI hostname from the initial bytes of a TLS stream,
+/// without a rustls_connection. `buf` should hold the bytes received so
+/// far, starting with the first byte of the stream; they are only parsed,
+/// never consumed, so the same bytes can afterwards be fed to a
+/// connection with rustls_connection_read_tls.
+///
+/// On success, the hostname is copied into `out_buf` (a buffer of size
+/// `count`) and its length is stored in *out_n. A success with *out_n set
+/// to 0 means the ClientHello is complete but carries no SNI extension.
+/// Returns RUSTLS_RESULT_HANDSHAKE_NOT_COMPLETE if `buf` does not yet
+/// contain the whole ClientHello (read more bytes and call again),
+/// RUSTLS_RESULT_INSUFFICIENT_SIZE if the hostname does not fit in
+/// `out_buf`, and RUSTLS_RESULT_CORRUPT_MESSAGE if the bytes are not a
+/// valid TLS ClientHello.
+///
+/// This enables asynchronous certificate resolution. A
+/// rustls_client_hello_callback must answer synchronously from inside
+/// packet processing, so a certificate that first needs a slow lookup
+/// (disk, sidecar) stalls the thread driving the handshake. Instead, peek
+/// at the SNI here before creating a connection, fetch the certificate
+/// however long that takes while other connections make progress, make it
+/// resolvable (for example by inserting it into the config's
+/// rustls_certified_key_map), and only then create the connection and
+/// replay the buffered bytes into it.
+#[no_mangle]
+pub extern "C" fn rustls_sni_from_client_hello(
+    buf: *const u8,
+    len: size_t,
+    out_buf: *mut u8,
+    count: size_t,
+    out_n: *mut size_t,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let input: &[u8] = try_slice!(buf, len);
+        let write_buf: &mut [u8] = try_mut_slice!(out_buf, count);
+        let out_n: &mut size_t = try_mut_from_ptr!(out_n);
+        *out_n = 0;
+
+        // The ClientHello may span several records; gather the handshake
+        // bytes until one full handshake message is available.
+        let mut rd = Reader::init(input);
+        let mut hs_bytes: Vec<u8> = Vec::new();
+        loop {
+            let msg = match Message::read_with_detailed_error(&mut rd) {
+                Ok(m) => m,
+                Err(MessageError::TooShortForHeader) | Err(MessageError::TooShortForLength) => {
+                    return rustls_result::HandshakeNotComplete;
+                }
+                Err(_) => return rustls_result::CorruptMessage,
+            };
+            if !msg.is_content_type(ContentType::Handshake) {
+                return rustls_result::CorruptMessage;
+            }
+            if let MessagePayload::Opaque(payload) = msg.payload {
+                hs_bytes.extend_from_slice(&payload.0);
+            }
+            // Whatever this is, it must at least claim to be a ClientHello.
+            if !hs_bytes.is_empty() && hs_bytes[0] != HandshakeType::ClientHello.get_u8() {
+                return rustls_result::CorruptMessage;
+            }
+            if hs_bytes.len() < 4 {
+                continue;
+            }
+            let msg_len: usize = ((hs_bytes[1] as usize) << 16)
+                | ((hs_bytes[2] as usize) << 8)
+                | hs_bytes[3] as usize;
+            if hs_bytes.len() < 4 + msg_len {
+                // Truncated handshake message; the next record continues it.
+                continue;
+            }
+            let mut hs_rd = Reader::init(&hs_bytes);
+            let parsed = HandshakeMessagePayload::read_version(&mut hs_rd, ProtocolVersion::TLSv1_2);
+            let client_hello = match parsed {
+                Some(HandshakeMessagePayload {
+                    payload: HandshakePayload::ClientHello(ch),
+                    ..
+                }) => ch,
+                _ => return rustls_result::CorruptMessage,
+            };
+            let hostname: &str = match client_hello
+                .get_sni_extension()
+                .and_then(|names| names.get_single_hostname())
+            {
+                Some(h) => h.into(),
+                None => return rustls_result::Ok,
+            };
+            if hostname.len() > write_buf.len() {
+                return rustls_result::InsufficientSize;
+            }
+            write_buf[..hostname.len()].copy_from_slice(hostname.as_bytes());
+            *out_n = hostname.len();
+            return rustls_result::Ok;
+        }
+    }
+}
+
+/// Return the SNI hostname as a borrowed rustls_str, without copying. The
+/// returned str is valid until the connection is freed; treating it as
+/// `'static` beyond that point is undefined behavior. Unlike
+/// rustls_server_connection_get_sni_hostname this needs no caller buffer,
+/// cannot fail for lack of space, and so never needs a retry. Returns a
+/// zero-length rustls_str if no SNI hostname is available on this
+/// connection, because it hasn't been processed yet, because the client
+/// did not send SNI, or because this is not a server connection.
+/// https://docs.rs/rustls/0.19.0/rustls/struct.ServerSession.html#method.get_sni_hostname
+#[no_mangle]
+pub extern "C" fn rustls_server_connection_get_sni_hostname_str(
+    conn: *const rustls_connection,
+) -> rustls_str<'static> {
+    ffi_panic_boundary! {
+        let conn: &Connection = try_ref_from_ptr!(conn);
+        let server_session = match conn.as_server() {
+            Some(s) => s,
+            _ => return Default::default(),
+        };
+        let sni_hostname = match server_session.get_sni_hostname() {
+            Some(sni_hostname) => sni_hostname,
+            None => return Default::default(),
+        };
+        // DNS names cannot contain NUL, but don't panic if one does.
+        let sni_hostname = match rustls_str::try_from(sni_hostname) {
+            Ok(s) => s,
+            Err(_) => return Default::default(),
+        };
+        // Documented above: valid until the connection is freed.
+        unsafe { sni_hostname.into_static() }
+    }
+}
+
 /// Choose the server certificate to be used for a session based on certificate
 /// type. Will pick the first CertfiedKey available that is suitable for
 /// the SignatureSchemes supported by the client.
@@ -411,6 +696,228 @@ impl ResolvesServerCert for ResolvesServerCertFromChoices {
     }
 }
 
+/// Like ResolvesServerCertFromChoices, but over swappable certified keys,
+/// so each handshake observes the OCSP response current at resolve time.
+struct ResolvesServerCertFromSwappableChoices {
+    choices: Vec<Arc<SwappableCertifiedKey>>,
+}
+
+impl ResolvesServerCert for ResolvesServerCertFromSwappableChoices {
+    fn resolve(&self, client_hello: ClientHello) -> Option<CertifiedKey> {
+        for key in self.choices.iter() {
+            let key = key.current();
+            if key.key.choose_scheme(client_hello.sigschemes()).is_some() {
+                return Some(key.as_ref().clone());
+            }
+        }
+        None
+    }
+}
+
+/// A mapping from DNS names to certified keys, for servers hosting many
+/// virtual hosts. Resolution during the handshake is a hash lookup on the
+/// SNI hostname (constant time in the number of entries), with support for
+/// single-label wildcard entries like "*.example.com". Fill the map with
+/// rustls_certified_key_map_insert, then install it on a server config
+/// builder with rustls_server_config_builder_set_key_map. This object is
+/// not safe for concurrent mutation. Under the hood, this object
+/// corresponds to a Box<CertifiedKeyMap>.
+pub struct rustls_certified_key_map {
+    // We use the opaque struct pattern to tell C about our types without
+    // telling them what's inside.
+    // https://doc.rust-lang.org/nomicon/ffi.html#representing-opaque-structs
+    _private: [u8; 0],
+}
+
+/// A map value: either a fixed key, or a swappable one whose OCSP
+/// response may be replaced while the map is in use.
+pub(crate) enum CertifiedKeyEntry {
+    Fixed(Arc<CertifiedKey>),
+    Swappable(Arc<SwappableCertifiedKey>),
+}
+
+impl CertifiedKeyEntry {
+    fn current(&self) -> Arc<CertifiedKey> {
+        match self {
+            CertifiedKeyEntry::Fixed(key) => key.clone(),
+            CertifiedKeyEntry::Swappable(key) => key.current(),
+        }
+    }
+}
+
+pub(crate) struct CertifiedKeyMap {
+    exact: HashMap<String, CertifiedKeyEntry>,
+    // Wildcard entries ("*.example.com"), keyed by the suffix including
+    // the leading dot (".example.com") so a lookup needs no allocation.
+    wildcard: HashMap<String, CertifiedKeyEntry>,
+}
+
+impl CastPtr for rustls_certified_key_map {
+    type RustType = CertifiedKeyMap;
+}
+
+impl CertifiedKeyMap {
+    /// Validate `dns_name` and insert `entry` under it.
+    fn insert_checked(&mut self, dns_name: &str, entry: CertifiedKeyEntry) -> rustls_result {
+        // SNI hostnames arrive in (ASCII) lowercase; store names likewise.
+        let dns_name = dns_name.to_ascii_lowercase();
+        match dns_name.strip_prefix("*.") {
+            Some(rest) => {
+                // webpki's DNSNameRef cannot represent a wildcard, so
+                // validate the part after the "*" and skip the cross-check
+                // against the (itself wildcard) certificate.
+                if webpki::DNSNameRef::try_from_ascii_str(rest).is_err() {
+                    return rustls_result::InvalidDnsNameError;
+                }
+                self.wildcard.insert(dns_name[1..].to_string(), entry);
+            }
+            None => {
+                let name_ref = match webpki::DNSNameRef::try_from_ascii_str(&dns_name) {
+                    Ok(r) => r,
+                    Err(_) => return rustls_result::InvalidDnsNameError,
+                };
+                if let Err(e) = entry.current().cross_check_end_entity_cert(Some(name_ref)) {
+                    return map_error(e);
+                }
+                self.exact.insert(dns_name, entry);
+            }
+        }
+        rustls_result::Ok
+    }
+}
+
+impl ResolvesServerCert for CertifiedKeyMap {
+    fn resolve(&self, client_hello: ClientHello) -> Option<CertifiedKey> {
+        // This kind of resolver requires SNI.
+        let name: &str = client_hello.server_name()?.into();
+        if let Some(entry) = self.exact.get(name) {
+            return Some(entry.current().as_ref().clone());
+        }
+        // A wildcard covers exactly one label: "a.b.example.com" is
+        // matched by "*.b.example.com" but not by "*.example.com".
+        let suffix = &name[name.find('.')?..];
+        self.wildcard
+            .get(suffix)
+            .map(|entry| entry.current().as_ref().clone())
+    }
+}
+
+/// Create a new, empty rustls_certified_key_map. Caller owns the memory
+/// and must either hand the map to rustls_server_config_builder_set_key_map
+/// (which takes ownership) or free it with rustls_certified_key_map_free.
+#[no_mangle]
+pub extern "C" fn rustls_certified_key_map_new() -> *mut rustls_certified_key_map {
+    ffi_panic_boundary! {
+        let map = CertifiedKeyMap {
+            exact: HashMap::new(),
+            wildcard: HashMap::new(),
+        };
+        Box::into_raw(Box::new(map)) as *mut _
+    }
+}
+
+/// Add a certified key to the map, to be used for connections whose SNI
+/// hostname equals `dns_name` (a NUL-terminated string). `dns_name` may
+/// start with "*." to match any single leading label, e.g. "*.example.com"
+/// matches "www.example.com" but neither "example.com" nor
+/// "a.b.example.com". Inserting a name that is already present replaces
+/// the earlier entry. For non-wildcard names, this checks that the key's
+/// end-entity certificate is valid for the name, and returns an error
+/// describing the problem if not. The map holds a reference to the key;
+/// the caller may free its own copy at any time.
+#[no_mangle]
+pub extern "C" fn rustls_certified_key_map_insert(
+    map: *mut rustls_certified_key_map,
+    dns_name: *const c_char,
+    key: *const rustls_certified_key,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let map: &mut CertifiedKeyMap = try_mut_from_ptr!(map);
+        let dns_name: &CStr = unsafe {
+            if dns_name.is_null() {
+                return NullParameter;
+            }
+            CStr::from_ptr(dns_name)
+        };
+        let dns_name: &str = match dns_name.to_str() {
+            Ok(s) => s,
+            Err(std::str::Utf8Error { .. }) => return rustls_result::InvalidDnsNameError,
+        };
+        let certified_key: Arc<CertifiedKey> = unsafe {
+            match (key as *const CertifiedKey).as_ref() {
+                Some(c) => arc_with_incref_from_raw(c),
+                None => return NullParameter,
+            }
+        };
+        map.insert_checked(dns_name, CertifiedKeyEntry::Fixed(certified_key))
+    }
+}
+
+/// Like rustls_certified_key_map_insert, but with a swappable certified
+/// key: the OCSP response published via
+/// rustls_swappable_certified_key_set_ocsp is picked up by handshakes
+/// resolving through this map, with no config rebuild. The map holds a
+/// reference to the swappable key; the caller may free its own copy at any
+/// time, but usually keeps it around to perform the swaps.
+#[no_mangle]
+pub extern "C" fn rustls_certified_key_map_insert_swappable(
+    map: *mut rustls_certified_key_map,
+    dns_name: *const c_char,
+    key: *const rustls_swappable_certified_key,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let map: &mut CertifiedKeyMap = try_mut_from_ptr!(map);
+        let dns_name: &CStr = unsafe {
+            if dns_name.is_null() {
+                return NullParameter;
+            }
+            CStr::from_ptr(dns_name)
+        };
+        let dns_name: &str = match dns_name.to_str() {
+            Ok(s) => s,
+            Err(std::str::Utf8Error { .. }) => return rustls_result::InvalidDnsNameError,
+        };
+        let key: Arc<SwappableCertifiedKey> = unsafe {
+            match (key as *const SwappableCertifiedKey).as_ref() {
+                Some(c) => arc_with_incref_from_raw(c),
+                None => return NullParameter,
+            }
+        };
+        map.insert_checked(dns_name, CertifiedKeyEntry::Swappable(key))
+    }
+}
+
+/// Use `map` to choose the server certificate based on the client's SNI
+/// hostname. This takes ownership of the map: the caller must not use or
+/// free it afterwards. Connections without SNI, or whose hostname matches
+/// no entry, fail their handshake. This replaces any certified keys set
+/// with rustls_server_config_builder_set_certified_keys (and vice versa).
+#[no_mangle]
+pub extern "C" fn rustls_server_config_builder_set_key_map(
+    builder: *mut rustls_server_config_builder,
+    map: *mut rustls_certified_key_map,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let config: &mut ServerConfig = try_mut_from_ptr!(builder);
+        let map: &mut CertifiedKeyMap = try_mut_from_ptr!(map);
+        let map: Box<CertifiedKeyMap> = unsafe { Box::from_raw(map) };
+        config.cert_resolver = Arc::new(*map);
+        rustls_result::Ok
+    }
+}
+
+/// Free a rustls_certified_key_map that was not handed to
+/// rustls_server_config_builder_set_key_map. Calling with NULL is fine.
+/// Must not be called twice with the same value.
+#[no_mangle]
+pub extern "C" fn rustls_certified_key_map_free(map: *mut rustls_certified_key_map) {
+    ffi_panic_boundary! {
+        let map: &mut CertifiedKeyMap = try_mut_from_ptr!(map);
+        // Convert the pointer to a Box and drop it.
+        unsafe { Box::from_raw(map); }
+    }
+}
+
 /// The TLS Client Hello information provided to a ClientHelloCallback function.
 /// `sni_name` is the SNI servername provided by the client. If the client
 /// did not provide an SNI, the length of this `rustls_string` will be 0.
@@ -653,3 +1160,122 @@ pub extern "C" fn rustls_server_config_builder_set_persistence(
         rustls_result::Ok
     }
 }
+
+/// Enable fully stateless session resumption using session tickets sealed
+/// with the given keys. `keys` must point to a buffer of `keys_len`
+/// `rustls_slice_bytes`, each holding one 32-byte ChaCha20-Poly1305 key.
+/// New tickets are sealed under the first key; tickets sealed under any of
+/// the other keys are still accepted, so keys can be rotated by prepending
+/// a fresh key and keeping the old ones around for as long as outstanding
+/// tickets should stay valid. Give all servers behind a load balancer the
+/// same keys and any of them can resume a session started on another, with
+/// no shared session store. `lifetime_seconds` is the ticket lifetime
+/// advertised to clients.
+///
+/// The keys are highly sensitive data: anyone holding them can decrypt
+/// sessions resumed with a ticket. This function copies the key material;
+/// the caller should zeroize its own copy when appropriate.
+///
+/// With a ticketer installed, the session store (whether registered via
+/// rustls_server_config_builder_set_persistence or
+/// rustls_server_config_builder_set_memory_cache) is no longer consulted
+/// for ticket-based resumption.
+#[no_mangle]
+pub extern "C" fn rustls_server_config_builder_set_ticket_keys(
+    builder: *mut rustls_server_config_builder,
+    keys: *const rustls_slice_bytes,
+    keys_len: size_t,
+    lifetime_seconds: u32,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let config: &mut ServerConfig = try_mut_from_ptr!(builder);
+        let keys: &[rustls_slice_bytes] = try_slice!(keys, keys_len);
+        if keys.is_empty() {
+            return InvalidParameter;
+        }
+        let mut key_slices: Vec<&[u8]> = Vec::with_capacity(keys.len());
+        for key in keys {
+            let key: &[u8] = try_slice!(key.data, key.len);
+            if key.len() != TICKET_KEY_LEN {
+                return InvalidParameter;
+            }
+            key_slices.push(key);
+        }
+        let ticketer = match CallerProvidedTicketer::new(&key_slices, lifetime_seconds) {
+            Some(t) => t,
+            None => return InvalidParameter,
+        };
+        config.ticketer = Arc::new(ticketer);
+        rustls_result::Ok
+    }
+}
+
+/// Register a built-in, in-memory store for TLS session IDs and secrets,
+/// holding up to `capacity` entries. Entries beyond the capacity evict the
+/// least recently used ones. The store is sharded over several independent
+/// locks internally, so resumption lookups from concurrent handshakes
+/// scale across cores without a global mutex, and no FFI callback is
+/// involved. `capacity` must be larger than 0.
+///
+/// This replaces any store previously registered on the builder, including
+/// callbacks registered via rustls_server_config_builder_set_persistence
+/// (and vice versa).
+#[no_mangle]
+pub extern "C" fn rustls_server_config_builder_set_memory_cache(
+    builder: *mut rustls_server_config_builder,
+    capacity: size_t,
+) -> rustls_result {
+    ffi_panic_boundary! {
+        let config: &mut ServerConfig = try_mut_from_ptr!(builder);
+        if capacity == 0 {
+            return InvalidParameter;
+        }
+        config.set_persistence(Arc::new(ShardedMemoryCache::new(capacity)));
+        rustls_result::Ok
+    }
+}
+
+#[test]
+fn test_sni_from_client_hello() {
+    use rustls::{ClientConfig, ClientSession, Session};
+
+    // A real ClientHello, as our own client would send it.
+    let config = Arc::new(ClientConfig::new());
+    let name = webpki::DNSNameRef::try_from_ascii_str("example.com").unwrap();
+    let mut session = ClientSession::new(&config, name);
+    let mut hello: Vec<u8> = Vec::new();
+    session.write_tls(&mut hello).unwrap();
+
+    let mut out = [0u8; 256];
+    let mut out_n: size_t = 0;
+    let result = rustls_sni_from_client_hello(
+        hello.as_ptr(),
+        hello.len(),
+        out.as_mut_ptr(),
+        out.len(),
+        &mut out_n,
+    );
+    assert!(matches!(result, rustls_result::Ok));
+    assert_eq!(&out[..out_n], b"example.com");
+
+    // A prefix is not a complete ClientHello yet.
+    let result = rustls_sni_from_client_hello(
+        hello.as_ptr(),
+        hello.len() - 1,
+        out.as_mut_ptr(),
+        out.len(),
+        &mut out_n,
+    );
+    assert!(matches!(result, rustls_result::HandshakeNotComplete));
+
+    // Bytes that are not TLS at all must be rejected.
+    let garbage = b"GET / HTTP/1.1\r\n";
+    let result = rustls_sni_from_client_hello(
+        garbage.as_ptr(),
+        garbage.len(),
+        out.as_mut_ptr(),
+        out.len(),
+        &mut out_n,
+    );
+    assert!(matches!(result, rustls_result::CorruptMessage));
+}
@@ -1,3 +1,11 @@
+use std::collections::hash_map::DefaultHasher;
+use std::hash::Hasher;
+use std::sync::Arc;
+
+use ring::aead;
+use ring::rand::{SecureRandom, SystemRandom};
+use rustls::{ProducesTickets, ServerSessionMemoryCache};
+
 use crate::error::rustls_result;
 use crate::rslice::rustls_slice_bytes;
 use crate::userdata_get;
@@ -160,3 +168,126 @@ impl rustls::StoresClientSessions for SessionStoreBroker {
 /// documented as a requirement in the API.
 unsafe impl Sync for SessionStoreBroker {}
 unsafe impl Send for SessionStoreBroker {}
+
+/// Number of independently locked shards in the cache built by
+/// rustls_server_config_builder_set_memory_cache. Each shard is a
+/// rustls::ServerSessionMemoryCache with its own mutex, so concurrent
+/// handshakes on different cores rarely contend on the same lock.
+const MEMORY_CACHE_SHARDS: usize = 16;
+
+/// An in-memory session store that spreads entries over several
+/// independently locked rustls::ServerSessionMemoryCache instances,
+/// selected by a hash of the session key.
+pub(crate) struct ShardedMemoryCache {
+    shards: Vec<Arc<ServerSessionMemoryCache>>,
+}
+
+impl ShardedMemoryCache {
+    pub fn new(capacity: usize) -> Self {
+        // Round up so the total capacity is at least what was asked for.
+        let per_shard = (capacity + MEMORY_CACHE_SHARDS - 1) / MEMORY_CACHE_SHARDS;
+        ShardedMemoryCache {
+            shards: (0..MEMORY_CACHE_SHARDS)
+                .map(|_| ServerSessionMemoryCache::new(per_shard))
+                .collect(),
+        }
+    }
+
+    fn shard(&self, key: &[u8]) -> &Arc<ServerSessionMemoryCache> {
+        let mut hasher = DefaultHasher::new();
+        hasher.write(key);
+        &self.shards[hasher.finish() as usize % self.shards.len()]
+    }
+}
+
+impl rustls::StoresServerSessions for ShardedMemoryCache {
+    fn put(&self, key: Vec<u8>, value: Vec<u8>) -> bool {
+        self.shard(&key).put(key, value)
+    }
+
+    fn get(&self, key: &[u8]) -> Option<Vec<u8>> {
+        self.shard(key).get(key)
+    }
+
+    fn take(&self, key: &[u8]) -> Option<Vec<u8>> {
+        self.shard(key).take(key)
+    }
+}
+
+/// Length in bytes of each key accepted by
+/// rustls_server_config_builder_set_ticket_keys: a ChaCha20-Poly1305 key.
+pub(crate) const TICKET_KEY_LEN: usize = 32;
+
+/// Length in bytes of the random nonce prepended to each ticket.
+const TICKET_NONCE_LEN: usize = 12;
+
+/// Produces and accepts stateless session tickets sealed with
+/// caller-provided ChaCha20-Poly1305 keys. New tickets are always sealed
+/// under the first key; tickets sealed under any of the other keys are
+/// still accepted. This follows the construction of rustls' built-in
+/// ticketer, but with key material supplied by the application so that
+/// several servers behind a load balancer can accept each other's tickets.
+pub(crate) struct CallerProvidedTicketer {
+    keys: Vec<aead::LessSafeKey>,
+    lifetime: u32,
+    rng: SystemRandom,
+}
+
+impl CallerProvidedTicketer {
+    /// Each element of `keys` must be TICKET_KEY_LEN bytes long.
+    pub fn new(keys: &[&[u8]], lifetime: u32) -> Option<Self> {
+        let mut aead_keys = Vec::with_capacity(keys.len());
+        for key in keys {
+            let key = aead::UnboundKey::new(&aead::CHACHA20_POLY1305, key).ok()?;
+            aead_keys.push(aead::LessSafeKey::new(key));
+        }
+        Some(CallerProvidedTicketer {
+            keys: aead_keys,
+            lifetime,
+            rng: SystemRandom::new(),
+        })
+    }
+}
+
+impl ProducesTickets for CallerProvidedTicketer {
+    fn enabled(&self) -> bool {
+        true
+    }
+
+    fn get_lifetime(&self) -> u32 {
+        self.lifetime
+    }
+
+    fn encrypt(&self, message: &[u8]) -> Option<Vec<u8>> {
+        // Random nonce, because a counter is a privacy leak.
+        let mut nonce_buf = [0u8; TICKET_NONCE_LEN];
+        self.rng.fill(&mut nonce_buf).ok()?;
+        let nonce = aead::Nonce::assume_unique_for_key(nonce_buf);
+
+        let mut ciphertext = Vec::with_capacity(
+            TICKET_NONCE_LEN + message.len() + self.keys[0].algorithm().tag_len(),
+        );
+        ciphertext.extend_from_slice(&nonce_buf);
+        let mut body = message.to_vec();
+        self.keys[0]
+            .seal_in_place_append_tag(nonce, aead::Aad::empty(), &mut body)
+            .ok()?;
+        ciphertext.extend(body);
+        Some(ciphertext)
+    }
+
+    fn decrypt(&self, ciphertext: &[u8]) -> Option<Vec<u8>> {
+        let nonce_buf = ciphertext.get(..TICKET_NONCE_LEN)?;
+        let sealed = ciphertext.get(TICKET_NONCE_LEN..)?;
+        for key in &self.keys {
+            let nonce = aead::Nonce::try_assume_unique_for_key(nonce_buf).ok()?;
+            let mut body = sealed.to_vec();
+            if let Ok(plaintext) = key.open_in_place(nonce, aead::Aad::empty(), &mut body) {
+                let len = plaintext.len();
+                body.truncate(len);
+                return Some(body);
+            }
+        }
+        None
+    }
+}
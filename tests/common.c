@@ -132,6 +132,38 @@ write_cb(void *userdata, const unsigned char *buf, size_t len, size_t *out_n)
   return 0;
 }
 
+rustls_io_result
+read_tls(struct rustls_connection *rconn, struct conndata *conn, size_t *n)
+{
+#ifdef _WIN32
+  return rustls_connection_read_tls(rconn, read_cb, conn, n);
+#else
+  if(getenv("VECTORED_IO")) {
+    return rustls_connection_read_tls_vectored(rconn, read_vectored_cb, conn, n);
+  }
+  else {
+    return rustls_connection_read_tls(rconn, read_cb, conn, n);
+  }
+#endif /* _WIN32 */
+}
+
+#ifndef _WIN32
+rustls_io_result
+read_vectored_cb(void *userdata, struct rustls_iovec *iov, size_t count,
+                 size_t *out_n)
+{
+  ssize_t n = 0;
+  struct conndata *conn = (struct conndata *)userdata;
+
+  n = readv(conn->fd, (const struct iovec *)iov, count);
+  if(n < 0) {
+    return errno;
+  }
+  *out_n = n;
+  return 0;
+}
+#endif /* _WIN32 */
+
 rustls_io_result
 write_tls(struct rustls_connection *rconn, struct conndata *conn, size_t *n)
 {
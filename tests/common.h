@@ -38,6 +38,11 @@ nonblock(int sockfd);
 int
 read_cb(void *userdata, uint8_t *buf, uintptr_t len, uintptr_t *out_n);
 
+/* Invoke rustls_connection_read_tls with either a vectored or unvectored
+   callback, depending on environment variable. */
+rustls_io_result
+read_tls(struct rustls_connection *rconn, struct conndata *conn, size_t *n);
+
 /* Invoke rustls_connection_write_tls with either a vectored or unvectored
    callback, depending on environment variable. */
 rustls_io_result
@@ -48,6 +53,9 @@ int
 write_cb(void *userdata, const uint8_t *buf, uintptr_t len, uintptr_t *out_n);
 
 #ifndef _WIN32
+rustls_io_result read_vectored_cb(
+    void *userdata, struct rustls_iovec *iov, size_t count, size_t *out_n);
+
 rustls_io_result write_vectored_cb(
     void *userdata, const struct rustls_iovec *iov, size_t count, size_t *out_n);
 #endif /* _WIN32 */
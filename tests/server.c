@@ -91,7 +91,7 @@ do_read(struct conndata *conn, struct rustls_connection *rconn)
   ssize_t signed_n = 0;
   char buf[1];
 
-  err = rustls_connection_read_tls(rconn, read_cb, conn, &n);
+  err = read_tls(rconn, conn, &n);
   if(err == EAGAIN || err == EWOULDBLOCK) {
     fprintf(stderr,
             "reading from socket: EAGAIN or EWOULDBLOCK: %s\n",
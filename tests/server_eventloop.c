@@ -0,0 +1,383 @@
+/* A single-threaded, epoll-driven TLS server. Unlike tests/server.c, which
+ * accepts one connection at a time and blocks on it until it closes, this
+ * multiplexes any number of concurrent rustls_connections over one
+ * nonblocking event loop — the architecture a real deployment (and a load
+ * test endpoint) wants. Connections come from a rustls_connection_pool, so
+ * steady-state accepts perform no heap allocation inside the library.
+ *
+ * Serves the same canned HTTP response as tests/server.c on port 8443:
+ *   ./target/server_eventloop localhost/cert.pem localhost/key.pem
+ *
+ * epoll is Linux-only; on other platforms this program only prints an
+ * error. A kqueue port would follow the same structure.
+ */
+
+#include <stdio.h>
+
+#ifndef __linux__
+
+int
+main(void)
+{
+  fprintf(stderr, "server_eventloop requires epoll and only runs on Linux\n");
+  return 1;
+}
+
+#else /* __linux__ */
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+/* crustls.h is autogenerated in the Makefile using cbindgen. */
+#include "crustls.h"
+#include "common.h"
+
+enum
+{
+  MAX_EVENTS = 64,
+  POOL_CAPACITY = 128,
+};
+
+/* Per-connection state. `conn` must stay first so the common.c callbacks
+ * can keep using struct conndata directly. */
+struct ev_conn
+{
+  struct conndata conn;
+  int sent_response;
+};
+
+static int epfd = -1;
+static struct rustls_connection_pool *pool = NULL;
+
+static enum crustls_demo_result
+read_file(const char *filename, char *buf, size_t buflen, size_t *n)
+{
+  FILE *f = fopen(filename, "r");
+  if(f == NULL) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    return CRUSTLS_DEMO_ERROR;
+  }
+  *n = fread(buf, 1, buflen, f);
+  if(!feof(f)) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    fclose(f);
+    return CRUSTLS_DEMO_ERROR;
+  }
+  fclose(f);
+  return CRUSTLS_DEMO_OK;
+}
+
+static const struct rustls_certified_key *
+load_cert_and_key(const char *certfile, const char *keyfile)
+{
+  char certbuf[10000];
+  size_t certbuf_len;
+  char keybuf[10000];
+  size_t keybuf_len;
+  const struct rustls_certified_key *certified_key;
+  int result;
+
+  result = read_file(certfile, certbuf, sizeof(certbuf), &certbuf_len);
+  if(result != CRUSTLS_DEMO_OK) {
+    return NULL;
+  }
+  result = read_file(keyfile, keybuf, sizeof(keybuf), &keybuf_len);
+  if(result != CRUSTLS_DEMO_OK) {
+    return NULL;
+  }
+  result = rustls_certified_key_build((uint8_t *)certbuf,
+                                      certbuf_len,
+                                      (uint8_t *)keybuf,
+                                      keybuf_len,
+                                      &certified_key);
+  if(result != RUSTLS_RESULT_OK) {
+    print_error("parsing certificate and key", result);
+    return NULL;
+  }
+  return certified_key;
+}
+
+static void
+close_conn(struct ev_conn *c)
+{
+  epoll_ctl(epfd, EPOLL_CTL_DEL, c->conn.fd, NULL);
+  close(c->conn.fd);
+  /* The connection goes back to the pool with its buffers intact; the
+   * next accept reuses them. */
+  rustls_connection_pool_return(pool, c->conn.rconn);
+  free(c->conn.data.data);
+  free(c);
+}
+
+/* Reflect the connection's current I/O appetite in its epoll
+ * registration. EPOLLIN stays on so we notice the peer closing. */
+static void
+update_interest(struct ev_conn *c)
+{
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  if(rustls_connection_wants_write(c->conn.rconn)) {
+    ev.events |= EPOLLOUT;
+  }
+  ev.data.ptr = c;
+  epoll_ctl(epfd, EPOLL_CTL_MOD, c->conn.fd, &ev);
+}
+
+/* Flush as many pending TLS bytes to the socket as it will take.
+ * Returns CRUSTLS_DEMO_OK or CRUSTLS_DEMO_ERROR. */
+static enum crustls_demo_result
+flush_writes(struct ev_conn *c)
+{
+  size_t n;
+  int err;
+
+  while(rustls_connection_wants_write(c->conn.rconn)) {
+    err = write_tls(c->conn.rconn, &c->conn, &n);
+    if(err == EAGAIN || err == EWOULDBLOCK) {
+      return CRUSTLS_DEMO_OK;
+    }
+    else if(err != 0 || n == 0) {
+      return CRUSTLS_DEMO_ERROR;
+    }
+  }
+  return CRUSTLS_DEMO_OK;
+}
+
+static enum crustls_demo_result
+send_response(struct ev_conn *c)
+{
+  const char *response = "HTTP/1.1 200 OK\r\nContent-Length: 6\r\n\r\nhello\n";
+  size_t n;
+
+  rustls_connection_write(
+    c->conn.rconn, (const uint8_t *)response, strlen(response), &n);
+  if(n != strlen(response)) {
+    fprintf(stderr, "failed to write all response bytes. wrote %zu\n", n);
+    return CRUSTLS_DEMO_ERROR;
+  }
+  return CRUSTLS_DEMO_OK;
+}
+
+/* Drain the socket into the connection and process what arrived. Returns
+ * CRUSTLS_DEMO_OK to keep the connection, anything else to close it. */
+static enum crustls_demo_result
+handle_readable(struct ev_conn *c)
+{
+  size_t n;
+  int err;
+  int result;
+
+  for(;;) {
+    err = read_tls(c->conn.rconn, &c->conn, &n);
+    if(err == EAGAIN || err == EWOULDBLOCK) {
+      break;
+    }
+    else if(err != 0) {
+      return CRUSTLS_DEMO_ERROR;
+    }
+    else if(n == 0) {
+      return CRUSTLS_DEMO_EOF;
+    }
+    result = rustls_connection_process_new_packets(c->conn.rconn);
+    if(result != RUSTLS_RESULT_OK) {
+      print_error("in process_new_packets", result);
+      return CRUSTLS_DEMO_ERROR;
+    }
+  }
+
+  result = copy_plaintext_to_buffer(&c->conn);
+  if(result == CRUSTLS_DEMO_CLOSE_NOTIFY) {
+    return CRUSTLS_DEMO_CLOSE_NOTIFY;
+  }
+  else if(result != CRUSTLS_DEMO_OK && result != CRUSTLS_DEMO_EOF) {
+    return CRUSTLS_DEMO_ERROR;
+  }
+
+  if(!c->sent_response && body_beginning(&c->conn.data) != NULL) {
+    c->sent_response = 1;
+    if(send_response(c) != CRUSTLS_DEMO_OK) {
+      return CRUSTLS_DEMO_ERROR;
+    }
+    /* We serve one response per connection; say goodbye politely. */
+    rustls_connection_send_close_notify(c->conn.rconn);
+  }
+  return CRUSTLS_DEMO_OK;
+}
+
+static void
+handle_accept(int listenfd)
+{
+  struct ev_conn *c;
+  struct epoll_event ev;
+  struct rustls_connection *rconn;
+  int clientfd;
+  int result;
+
+  for(;;) {
+    clientfd = accept(listenfd, NULL, NULL);
+    if(clientfd < 0) {
+      if(errno != EAGAIN && errno != EWOULDBLOCK) {
+        perror("accept");
+      }
+      return;
+    }
+    nonblock(clientfd);
+
+    result = rustls_connection_pool_take(pool, &rconn);
+    if(result != RUSTLS_RESULT_OK) {
+      print_error("taking connection from pool", result);
+      close(clientfd);
+      return;
+    }
+
+    c = calloc(1, sizeof(struct ev_conn));
+    c->conn.fd = clientfd;
+    c->conn.rconn = rconn;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.ptr = c;
+    if(epoll_ctl(epfd, EPOLL_CTL_ADD, clientfd, &ev) < 0) {
+      perror("epoll_ctl add");
+      close_conn(c);
+      return;
+    }
+  }
+}
+
+int
+main(int argc, const char **argv)
+{
+  int ret = 1;
+  int listenfd = -1;
+  int nfds;
+  int i;
+  struct rustls_server_config_builder *config_builder = NULL;
+  const struct rustls_server_config *server_config = NULL;
+  const struct rustls_certified_key *certified_key;
+  struct sockaddr_in my_addr;
+  struct epoll_event ev;
+  struct epoll_event events[MAX_EVENTS];
+  struct ev_conn *c;
+  int enable = 1;
+
+  if(argc <= 2) {
+    fprintf(stderr,
+            "usage: %s cert.pem key.pem\n\n"
+            "Listen on port 8443 with the given cert and key,\n"
+            "serving any number of concurrent connections.\n",
+            argv[0]);
+    goto cleanup;
+  }
+
+  certified_key = load_cert_and_key(argv[1], argv[2]);
+  if(certified_key == NULL) {
+    goto cleanup;
+  }
+
+  config_builder = rustls_server_config_builder_new();
+  rustls_server_config_builder_set_certified_keys(
+    config_builder, &certified_key, 1);
+  server_config = rustls_server_config_builder_build(config_builder);
+  pool = rustls_connection_pool_new(server_config, POOL_CAPACITY);
+
+  listenfd = socket(AF_INET, SOCK_STREAM, 0);
+  if(listenfd < 0) {
+    perror("making socket");
+    goto cleanup;
+  }
+  if(setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int)) <
+     0) {
+    perror("setsockopt(SO_REUSEADDR)");
+  }
+
+  memset(&my_addr, 0, sizeof(struct sockaddr_in));
+  my_addr.sin_family = AF_INET;
+  my_addr.sin_port = htons(8443);
+  inet_aton("127.0.0.1", &my_addr.sin_addr);
+
+  if(bind(listenfd, (struct sockaddr *)&my_addr, sizeof(struct sockaddr_in)) ==
+     -1) {
+    perror("bind");
+    goto cleanup;
+  }
+  if(listen(listenfd, 512) == -1) {
+    perror("listen");
+    goto cleanup;
+  }
+  nonblock(listenfd);
+  fprintf(stderr, "listening on localhost:8443\n");
+
+  epfd = epoll_create1(0);
+  if(epfd < 0) {
+    perror("epoll_create1");
+    goto cleanup;
+  }
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL; /* NULL marks the listener. */
+  if(epoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &ev) < 0) {
+    perror("epoll_ctl add listener");
+    goto cleanup;
+  }
+
+  for(;;) {
+    nfds = epoll_wait(epfd, events, MAX_EVENTS, -1);
+    if(nfds < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      perror("epoll_wait");
+      goto cleanup;
+    }
+    for(i = 0; i < nfds; i++) {
+      c = events[i].data.ptr;
+      if(c == NULL) {
+        handle_accept(listenfd);
+        continue;
+      }
+      if(events[i].events & (EPOLLERR | EPOLLHUP)) {
+        close_conn(c);
+        continue;
+      }
+      if((events[i].events & EPOLLIN) &&
+         handle_readable(c) != CRUSTLS_DEMO_OK) {
+        close_conn(c);
+        continue;
+      }
+      if(flush_writes(c) != CRUSTLS_DEMO_OK) {
+        close_conn(c);
+        continue;
+      }
+      /* The exchange is over once the response (and close_notify) have
+       * left the building. */
+      if(c->sent_response &&
+         !rustls_connection_wants_write(c->conn.rconn)) {
+        close_conn(c);
+        continue;
+      }
+      update_interest(c);
+    }
+  }
+
+cleanup:
+  rustls_connection_pool_free(pool);
+  rustls_server_config_free(server_config);
+  if(listenfd >= 0) {
+    close(listenfd);
+  }
+  if(epfd >= 0) {
+    close(epfd);
+  }
+  return ret;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,291 @@
+/* A multithreaded TLS server: N worker threads share one
+ * rustls_server_config, each accepting on its own SO_REUSEPORT listener so
+ * the kernel load-balances incoming connections across threads with no
+ * shared accept lock. This demonstrates the intended concurrency model:
+ * rustls_server_config is an Arc under the hood (see the header docs), so
+ * one config can safely serve connections on any number of threads, and
+ * per-core throughput scales with the thread count because the workers
+ * share no mutable state at all.
+ *
+ * Serves the same canned HTTP response as tests/server.c on port 8443:
+ *   ./target/server_threaded 4 localhost/cert.pem localhost/key.pem
+ *
+ * To measure scaling, drive it with an external load generator (e.g.
+ * h2load or wrk with TLS) while varying the thread count.
+ *
+ * SO_REUSEPORT balancing is available on Linux and the BSDs; this demo is
+ * not built on Windows.
+ */
+
+#include <stdio.h>
+
+#ifdef _WIN32
+
+int
+main(void)
+{
+  fprintf(stderr, "server_threaded requires SO_REUSEPORT and POSIX threads\n");
+  return 1;
+}
+
+#else /* !_WIN32 */
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+
+/* crustls.h is autogenerated in the Makefile using cbindgen. */
+#include "crustls.h"
+#include "common.h"
+
+struct worker
+{
+  pthread_t thread;
+  int id;
+  const struct rustls_server_config *config;
+};
+
+static enum crustls_demo_result
+read_file(const char *filename, char *buf, size_t buflen, size_t *n)
+{
+  FILE *f = fopen(filename, "r");
+  if(f == NULL) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    return CRUSTLS_DEMO_ERROR;
+  }
+  *n = fread(buf, 1, buflen, f);
+  if(!feof(f)) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    fclose(f);
+    return CRUSTLS_DEMO_ERROR;
+  }
+  fclose(f);
+  return CRUSTLS_DEMO_OK;
+}
+
+static const struct rustls_certified_key *
+load_cert_and_key(const char *certfile, const char *keyfile)
+{
+  char certbuf[10000];
+  size_t certbuf_len;
+  char keybuf[10000];
+  size_t keybuf_len;
+  const struct rustls_certified_key *certified_key;
+  int result;
+
+  result = read_file(certfile, certbuf, sizeof(certbuf), &certbuf_len);
+  if(result != CRUSTLS_DEMO_OK) {
+    return NULL;
+  }
+  result = read_file(keyfile, keybuf, sizeof(keybuf), &keybuf_len);
+  if(result != CRUSTLS_DEMO_OK) {
+    return NULL;
+  }
+  result = rustls_certified_key_build((uint8_t *)certbuf,
+                                      certbuf_len,
+                                      (uint8_t *)keybuf,
+                                      keybuf_len,
+                                      &certified_key);
+  if(result != RUSTLS_RESULT_OK) {
+    print_error("parsing certificate and key", result);
+    return NULL;
+  }
+  return certified_key;
+}
+
+static enum crustls_demo_result
+flush_writes(struct conndata *conn)
+{
+  size_t n;
+  int err;
+
+  while(rustls_connection_wants_write(conn->rconn)) {
+    err = write_tls(conn->rconn, conn, &n);
+    if(err != 0 || n == 0) {
+      return CRUSTLS_DEMO_ERROR;
+    }
+  }
+  return CRUSTLS_DEMO_OK;
+}
+
+static enum crustls_demo_result
+send_response(struct conndata *conn)
+{
+  const char *response = "HTTP/1.1 200 OK\r\nContent-Length: 6\r\n\r\nhello\n";
+  size_t n;
+
+  rustls_connection_write(
+    conn->rconn, (const uint8_t *)response, strlen(response), &n);
+  if(n != strlen(response)) {
+    fprintf(stderr, "failed to write all response bytes. wrote %zu\n", n);
+    return CRUSTLS_DEMO_ERROR;
+  }
+  return CRUSTLS_DEMO_OK;
+}
+
+/* One request/response exchange on a blocking socket. The client speaks
+ * first, so each loop iteration reads, processes, then flushes whatever
+ * rustls queued in response. */
+static void
+handle_conn(const struct rustls_server_config *config, int fd)
+{
+  struct conndata conn;
+  struct rustls_connection *rconn = NULL;
+  size_t n;
+  int err;
+  int result;
+
+  if(rustls_server_connection_new(config, &rconn) != RUSTLS_RESULT_OK) {
+    close(fd);
+    return;
+  }
+  memset(&conn, 0, sizeof(conn));
+  conn.fd = fd;
+  conn.rconn = rconn;
+
+  for(;;) {
+    err = read_tls(rconn, &conn, &n);
+    if(err != 0 || n == 0) {
+      break;
+    }
+    result = rustls_connection_process_new_packets(rconn);
+    if(result != RUSTLS_RESULT_OK) {
+      print_error("in process_new_packets", result);
+      break;
+    }
+    result = copy_plaintext_to_buffer(&conn);
+    if(result != CRUSTLS_DEMO_OK && result != CRUSTLS_DEMO_EOF) {
+      break;
+    }
+    if(body_beginning(&conn.data) != NULL) {
+      if(send_response(&conn) != CRUSTLS_DEMO_OK) {
+        break;
+      }
+      rustls_connection_send_close_notify(rconn);
+      flush_writes(&conn);
+      break;
+    }
+    if(flush_writes(&conn) != CRUSTLS_DEMO_OK) {
+      break;
+    }
+  }
+
+  free(conn.data.data);
+  rustls_connection_free(rconn);
+  close(fd);
+}
+
+static void *
+worker_main(void *arg)
+{
+  struct worker *w = arg;
+  struct sockaddr_in my_addr;
+  int listenfd;
+  int clientfd;
+  int enable = 1;
+
+  /* Each worker binds its own listener to the same port; SO_REUSEPORT
+   * makes the kernel spread incoming connections across them. */
+  listenfd = socket(AF_INET, SOCK_STREAM, 0);
+  if(listenfd < 0) {
+    perror("making socket");
+    return NULL;
+  }
+  if(setsockopt(
+       listenfd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) < 0) {
+    perror("setsockopt(SO_REUSEPORT)");
+    close(listenfd);
+    return NULL;
+  }
+
+  memset(&my_addr, 0, sizeof(struct sockaddr_in));
+  my_addr.sin_family = AF_INET;
+  my_addr.sin_port = htons(8443);
+  inet_aton("127.0.0.1", &my_addr.sin_addr);
+
+  if(bind(listenfd, (struct sockaddr *)&my_addr, sizeof(struct sockaddr_in)) ==
+     -1) {
+    perror("bind");
+    close(listenfd);
+    return NULL;
+  }
+  if(listen(listenfd, 512) == -1) {
+    perror("listen");
+    close(listenfd);
+    return NULL;
+  }
+  fprintf(stderr, "worker %d listening on localhost:8443\n", w->id);
+
+  for(;;) {
+    clientfd = accept(listenfd, NULL, NULL);
+    if(clientfd < 0) {
+      perror("accept");
+      break;
+    }
+    handle_conn(w->config, clientfd);
+  }
+  close(listenfd);
+  return NULL;
+}
+
+int
+main(int argc, const char **argv)
+{
+  struct rustls_server_config_builder *config_builder;
+  const struct rustls_server_config *server_config;
+  const struct rustls_certified_key *certified_key;
+  struct worker *workers;
+  long num_workers;
+  long i;
+
+  if(argc <= 3) {
+    fprintf(stderr,
+            "usage: %s num_threads cert.pem key.pem\n\n"
+            "Listen on port 8443 with the given cert and key, accepting\n"
+            "on num_threads workers that share one server config.\n",
+            argv[0]);
+    return 1;
+  }
+  num_workers = strtol(argv[1], NULL, 10);
+  if(num_workers < 1 || num_workers > 1024) {
+    fprintf(stderr, "num_threads must be between 1 and 1024\n");
+    return 1;
+  }
+
+  certified_key = load_cert_and_key(argv[2], argv[3]);
+  if(certified_key == NULL) {
+    return 1;
+  }
+
+  config_builder = rustls_server_config_builder_new();
+  rustls_server_config_builder_set_certified_keys(
+    config_builder, &certified_key, 1);
+  server_config = rustls_server_config_builder_build(config_builder);
+
+  workers = calloc(num_workers, sizeof(struct worker));
+  for(i = 0; i < num_workers; i++) {
+    workers[i].id = (int)i;
+    /* All workers share the one config; it is reference-counted and
+     * immutable, so no additional synchronization is needed. */
+    workers[i].config = server_config;
+    if(pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) !=
+       0) {
+      perror("pthread_create");
+      return 1;
+    }
+  }
+  for(i = 0; i < num_workers; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+
+  free(workers);
+  rustls_server_config_free(server_config);
+  return 0;
+}
+
+#endif /* !_WIN32 */
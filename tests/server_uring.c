@@ -0,0 +1,536 @@
+/* An io_uring-driven TLS server. Where tests/server_eventloop.c makes one
+ * read(2) or write(2) syscall per ready socket per wakeup, this batches: all
+ * pending reads, writes and accepts are queued as submission entries and
+ * handed to the kernel in a single io_uring_enter(2) per loop iteration,
+ * which also collects every completion that has arrived. TLS bytes move
+ * through rustls_connection_read_tls_from_buf and
+ * rustls_connection_write_tls_into_buf, the callback-free I/O functions
+ * designed for completion-based APIs: the kernel fills (or drains) a
+ * caller-owned buffer asynchronously, and the connection is fed (or
+ * topped up) only once the completion arrives.
+ *
+ * Serves the same canned HTTP response as tests/server.c on port 8443:
+ *   ./target/server_uring localhost/cert.pem localhost/key.pem
+ *
+ * To keep the demo dependency-free this speaks the raw io_uring syscall
+ * interface (<linux/io_uring.h>) rather than liburing; a production
+ * application would use liburing and keep the same structure. Requires
+ * Linux 5.6 or newer (IORING_OP_RECV/SEND); on other platforms this
+ * program only prints an error.
+ */
+
+#include <stdio.h>
+
+#ifndef __linux__
+
+int
+main(void)
+{
+  fprintf(stderr, "server_uring requires io_uring and only runs on Linux\n");
+  return 1;
+}
+
+#else /* __linux__ */
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+/* crustls.h is autogenerated in the Makefile using cbindgen. */
+#include "crustls.h"
+#include "common.h"
+
+enum
+{
+  QUEUE_DEPTH = 256,
+  NETBUF_SIZE = 16384,
+};
+
+/* ---- Minimal io_uring plumbing (what liburing would otherwise do) ---- */
+
+struct uring
+{
+  int fd;
+  unsigned sq_entries;
+  unsigned sq_pending; /* sqes queued locally, not yet visible to the kernel */
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+};
+
+static int
+sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+  return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                   unsigned flags)
+{
+  return (int)syscall(
+    __NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int
+uring_init(struct uring *r, unsigned entries)
+{
+  struct io_uring_params p;
+  size_t sring_sz, cring_sz, ring_sz;
+  char *ring;
+
+  memset(&p, 0, sizeof(p));
+  r->fd = sys_io_uring_setup(entries, &p);
+  if(r->fd < 0) {
+    perror("io_uring_setup");
+    return -1;
+  }
+  if(!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+    fprintf(stderr, "kernel too old for this demo (needs Linux >= 5.6)\n");
+    return -1;
+  }
+  sring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cring_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  ring_sz = sring_sz > cring_sz ? sring_sz : cring_sz;
+  ring = mmap(NULL,
+              ring_sz,
+              PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE,
+              r->fd,
+              IORING_OFF_SQ_RING);
+  if(ring == MAP_FAILED) {
+    perror("mmap rings");
+    return -1;
+  }
+  r->sq_entries = p.sq_entries;
+  r->sq_pending = 0;
+  r->sq_head = (unsigned *)(ring + p.sq_off.head);
+  r->sq_tail = (unsigned *)(ring + p.sq_off.tail);
+  r->sq_mask = (unsigned *)(ring + p.sq_off.ring_mask);
+  r->sq_array = (unsigned *)(ring + p.sq_off.array);
+  r->cq_head = (unsigned *)(ring + p.cq_off.head);
+  r->cq_tail = (unsigned *)(ring + p.cq_off.tail);
+  r->cq_mask = (unsigned *)(ring + p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe *)(ring + p.cq_off.cqes);
+  r->sqes = mmap(NULL,
+                 p.sq_entries * sizeof(struct io_uring_sqe),
+                 PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE,
+                 r->fd,
+                 IORING_OFF_SQES);
+  if(r->sqes == MAP_FAILED) {
+    perror("mmap sqes");
+    return -1;
+  }
+  return 0;
+}
+
+/* Publish all locally queued sqes and wait for at least one completion.
+ * This is the only syscall in the steady-state loop. */
+static int
+uring_submit_and_wait(struct uring *r)
+{
+  unsigned n = r->sq_pending;
+
+  __atomic_store_n(r->sq_tail, *r->sq_tail + n, __ATOMIC_RELEASE);
+  r->sq_pending = 0;
+  return sys_io_uring_enter(r->fd, n, 1, IORING_ENTER_GETEVENTS);
+}
+
+/* Reserve the next sqe, zeroed, with its index placed in the sq array.
+ * The demo's queue depth comfortably exceeds one sqe per connection, so
+ * we treat a full queue as a bug rather than flushing mid-loop. */
+static struct io_uring_sqe *
+uring_get_sqe(struct uring *r)
+{
+  unsigned tail = *r->sq_tail + r->sq_pending;
+  unsigned idx = tail & *r->sq_mask;
+
+  if(tail - *r->sq_head == r->sq_entries) {
+    fprintf(stderr, "submission queue overflow\n");
+    exit(1);
+  }
+  r->sq_array[idx] = idx;
+  r->sq_pending++;
+  memset(&r->sqes[idx], 0, sizeof(struct io_uring_sqe));
+  return &r->sqes[idx];
+}
+
+/* Copy out the next completion, if any. Returns 1 if *out was filled. */
+static int
+uring_next_cqe(struct uring *r, struct io_uring_cqe *out)
+{
+  unsigned head = *r->cq_head;
+
+  if(head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+    return 0;
+  }
+  *out = r->cqes[head & *r->cq_mask];
+  __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+/* ---- The TLS server proper ---- */
+
+/* Per-connection state. Each connection has exactly one io_uring operation
+ * outstanding at a time, so a single network buffer serves both
+ * directions. `conn` must stay first so the common.c helpers can keep
+ * using struct conndata directly. */
+struct uring_conn
+{
+  struct conndata conn;
+  uint8_t netbuf[NETBUF_SIZE];
+  size_t out_len; /* TLS bytes staged in netbuf awaiting send */
+  size_t out_off; /* how much of out_len the kernel has taken */
+  int writing;    /* outstanding op is a send, not a recv */
+  int sent_response;
+};
+
+static struct uring ring;
+
+static enum crustls_demo_result
+read_file(const char *filename, char *buf, size_t buflen, size_t *n)
+{
+  FILE *f = fopen(filename, "r");
+  if(f == NULL) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    return CRUSTLS_DEMO_ERROR;
+  }
+  *n = fread(buf, 1, buflen, f);
+  if(!feof(f)) {
+    fprintf(stderr, "%s\n", strerror(errno));
+    fclose(f);
+    return CRUSTLS_DEMO_ERROR;
+  }
+  fclose(f);
+  return CRUSTLS_DEMO_OK;
+}
+
+static const struct rustls_certified_key *
+load_cert_and_key(const char *certfile, const char *keyfile)
+{
+  char certbuf[10000];
+  size_t certbuf_len;
+  char keybuf[10000];
+  size_t keybuf_len;
+  const struct rustls_certified_key *certified_key;
+  int result;
+
+  result = read_file(certfile, certbuf, sizeof(certbuf), &certbuf_len);
+  if(result != CRUSTLS_DEMO_OK) {
+    return NULL;
+  }
+  result = read_file(keyfile, keybuf, sizeof(keybuf), &keybuf_len);
+  if(result != CRUSTLS_DEMO_OK) {
+    return NULL;
+  }
+  result = rustls_certified_key_build((uint8_t *)certbuf,
+                                      certbuf_len,
+                                      (uint8_t *)keybuf,
+                                      keybuf_len,
+                                      &certified_key);
+  if(result != RUSTLS_RESULT_OK) {
+    print_error("parsing certificate and key", result);
+    return NULL;
+  }
+  return certified_key;
+}
+
+static void
+close_conn(struct uring_conn *c)
+{
+  close(c->conn.fd);
+  rustls_connection_free(c->conn.rconn);
+  free(c->conn.data.data);
+  free(c);
+}
+
+/* Queue a recv of TLS bytes into the connection's buffer. The completion
+ * handler feeds whatever arrives to the rustls_connection. */
+static void
+submit_read(struct uring_conn *c)
+{
+  struct io_uring_sqe *sqe = uring_get_sqe(&ring);
+
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = c->conn.fd;
+  sqe->addr = (unsigned long)c->netbuf;
+  sqe->len = sizeof(c->netbuf);
+  sqe->user_data = (unsigned long)c;
+  c->writing = 0;
+}
+
+/* Drain the connection's pending TLS output into netbuf and queue a send
+ * of it. Returns 1 if a send was queued, 0 if there was nothing to send. */
+static int
+submit_write(struct uring_conn *c)
+{
+  struct io_uring_sqe *sqe;
+  size_t n = 0;
+  int err;
+
+  err = rustls_connection_write_tls_into_buf(
+    c->conn.rconn, c->netbuf, sizeof(c->netbuf), &n);
+  if(err != 0 || n == 0) {
+    return 0;
+  }
+  c->out_len = n;
+  c->out_off = 0;
+  sqe = uring_get_sqe(&ring);
+  sqe->opcode = IORING_OP_SEND;
+  sqe->fd = c->conn.fd;
+  sqe->addr = (unsigned long)c->netbuf;
+  sqe->len = n;
+  sqe->user_data = (unsigned long)c;
+  c->writing = 1;
+  return 1;
+}
+
+/* Queue the next operation for a connection that has nothing in flight:
+ * pending TLS output if there is any, otherwise a read — unless the
+ * exchange is over, in which case close. */
+static void
+submit_next(struct uring_conn *c)
+{
+  if(submit_write(c)) {
+    return;
+  }
+  if(c->sent_response) {
+    /* Response and close_notify have left the building. */
+    close_conn(c);
+    return;
+  }
+  submit_read(c);
+}
+
+static enum crustls_demo_result
+send_response(struct uring_conn *c)
+{
+  const char *response = "HTTP/1.1 200 OK\r\nContent-Length: 6\r\n\r\nhello\n";
+  size_t n;
+
+  rustls_connection_write(
+    c->conn.rconn, (const uint8_t *)response, strlen(response), &n);
+  if(n != strlen(response)) {
+    fprintf(stderr, "failed to write all response bytes. wrote %zu\n", n);
+    return CRUSTLS_DEMO_ERROR;
+  }
+  return CRUSTLS_DEMO_OK;
+}
+
+/* Feed `n` freshly received TLS bytes to the connection and process them.
+ * Returns CRUSTLS_DEMO_OK to keep the connection, anything else to
+ * close it. */
+static enum crustls_demo_result
+handle_received(struct uring_conn *c, size_t n)
+{
+  size_t fed = 0;
+  size_t taken;
+  int err;
+  int result;
+
+  while(fed < n) {
+    err = rustls_connection_read_tls_from_buf(
+      c->conn.rconn, c->netbuf + fed, n - fed, &taken);
+    if(err != 0 || taken == 0) {
+      return CRUSTLS_DEMO_ERROR;
+    }
+    fed += taken;
+    result = rustls_connection_process_new_packets(c->conn.rconn);
+    if(result != RUSTLS_RESULT_OK) {
+      print_error("in process_new_packets", result);
+      return CRUSTLS_DEMO_ERROR;
+    }
+  }
+
+  result = copy_plaintext_to_buffer(&c->conn);
+  if(result == CRUSTLS_DEMO_CLOSE_NOTIFY) {
+    return CRUSTLS_DEMO_CLOSE_NOTIFY;
+  }
+  else if(result != CRUSTLS_DEMO_OK && result != CRUSTLS_DEMO_EOF) {
+    return CRUSTLS_DEMO_ERROR;
+  }
+
+  if(!c->sent_response && body_beginning(&c->conn.data) != NULL) {
+    c->sent_response = 1;
+    if(send_response(c) != CRUSTLS_DEMO_OK) {
+      return CRUSTLS_DEMO_ERROR;
+    }
+    /* We serve one response per connection; say goodbye politely. */
+    rustls_connection_send_close_notify(c->conn.rconn);
+  }
+  return CRUSTLS_DEMO_OK;
+}
+
+/* Queue an accept on the listener. user_data of 0 marks it. */
+static void
+submit_accept(int listenfd)
+{
+  struct io_uring_sqe *sqe = uring_get_sqe(&ring);
+
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = listenfd;
+  sqe->user_data = 0;
+}
+
+static void
+handle_accept(const struct rustls_server_config *server_config, int listenfd,
+              int clientfd)
+{
+  struct uring_conn *c;
+  struct rustls_connection *rconn;
+  int result;
+
+  /* Keep one accept outstanding at all times. */
+  submit_accept(listenfd);
+
+  if(clientfd < 0) {
+    fprintf(stderr, "accept: %s\n", strerror(-clientfd));
+    return;
+  }
+  result = rustls_server_connection_new(server_config, &rconn);
+  if(result != RUSTLS_RESULT_OK) {
+    print_error("making server connection", result);
+    close(clientfd);
+    return;
+  }
+  c = calloc(1, sizeof(struct uring_conn));
+  c->conn.fd = clientfd;
+  c->conn.rconn = rconn;
+  submit_read(c);
+}
+
+static void
+handle_completion(struct uring_conn *c, int res)
+{
+  if(res <= 0) {
+    /* Error or peer hangup; close_notify shows up as a clean TLS-level
+     * close before this. */
+    close_conn(c);
+    return;
+  }
+  if(c->writing) {
+    c->out_off += (size_t)res;
+    if(c->out_off < c->out_len) {
+      /* Short send: queue the remainder. */
+      struct io_uring_sqe *sqe = uring_get_sqe(&ring);
+      sqe->opcode = IORING_OP_SEND;
+      sqe->fd = c->conn.fd;
+      sqe->addr = (unsigned long)(c->netbuf + c->out_off);
+      sqe->len = c->out_len - c->out_off;
+      sqe->user_data = (unsigned long)c;
+      return;
+    }
+  }
+  else if(handle_received(c, (size_t)res) != CRUSTLS_DEMO_OK) {
+    close_conn(c);
+    return;
+  }
+  submit_next(c);
+}
+
+int
+main(int argc, const char **argv)
+{
+  int ret = 1;
+  int listenfd = -1;
+  struct rustls_server_config_builder *config_builder = NULL;
+  const struct rustls_server_config *server_config = NULL;
+  const struct rustls_certified_key *certified_key;
+  struct sockaddr_in my_addr;
+  struct io_uring_cqe cqe;
+  int enable = 1;
+
+  if(argc <= 2) {
+    fprintf(stderr,
+            "usage: %s cert.pem key.pem\n\n"
+            "Listen on port 8443 with the given cert and key,\n"
+            "serving any number of concurrent connections over io_uring.\n",
+            argv[0]);
+    goto cleanup;
+  }
+
+  certified_key = load_cert_and_key(argv[1], argv[2]);
+  if(certified_key == NULL) {
+    goto cleanup;
+  }
+
+  config_builder = rustls_server_config_builder_new();
+  rustls_server_config_builder_set_certified_keys(
+    config_builder, &certified_key, 1);
+  server_config = rustls_server_config_builder_build(config_builder);
+
+  listenfd = socket(AF_INET, SOCK_STREAM, 0);
+  if(listenfd < 0) {
+    perror("making socket");
+    goto cleanup;
+  }
+  if(setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int)) <
+     0) {
+    perror("setsockopt(SO_REUSEADDR)");
+  }
+
+  memset(&my_addr, 0, sizeof(struct sockaddr_in));
+  my_addr.sin_family = AF_INET;
+  my_addr.sin_port = htons(8443);
+  inet_aton("127.0.0.1", &my_addr.sin_addr);
+
+  if(bind(listenfd, (struct sockaddr *)&my_addr, sizeof(struct sockaddr_in)) ==
+     -1) {
+    perror("bind");
+    goto cleanup;
+  }
+  if(listen(listenfd, 512) == -1) {
+    perror("listen");
+    goto cleanup;
+  }
+  fprintf(stderr, "listening on localhost:8443\n");
+
+  if(uring_init(&ring, QUEUE_DEPTH) < 0) {
+    goto cleanup;
+  }
+  submit_accept(listenfd);
+
+  for(;;) {
+    if(uring_submit_and_wait(&ring) < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      perror("io_uring_enter");
+      goto cleanup;
+    }
+    /* Handle every completion that arrived; the handlers queue follow-up
+     * sqes locally, and the next loop iteration submits them all in one
+     * syscall. */
+    while(uring_next_cqe(&ring, &cqe)) {
+      if(cqe.user_data == 0) {
+        handle_accept(server_config, listenfd, cqe.res);
+      }
+      else {
+        handle_completion((struct uring_conn *)cqe.user_data, cqe.res);
+      }
+    }
+  }
+
+cleanup:
+  rustls_server_config_free(server_config);
+  if(listenfd >= 0) {
+    close(listenfd);
+  }
+  return ret;
+}
+
+#endif /* __linux__ */